@@ -0,0 +1,119 @@
+"""
+Headless multi-output render benchmark
+
+Starts pywm on the headless backend with several (by default 4K) outputs, puts
+one fullscreen client on each and reports the time spent rendering on the
+compositor thread, as aggregated by TIMER[render] in wm_output.c every 10s.
+
+    python dev/benchmark_outputs.py -n 3 -e "weston-simple-egl -f"
+
+Outputs are rendered one after another, so the render load (share of wall
+time the compositor thread spends rendering) adds up over the outputs.
+"""
+from __future__ import annotations
+from typing import Any, Optional
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+import time
+
+parser = argparse.ArgumentParser()
+parser.add_argument("-n", "--outputs", type=int, default=3)
+parser.add_argument("-W", "--width", type=int, default=3840)
+parser.add_argument("-H", "--height", type=int, default=2160)
+parser.add_argument("-r", "--mhz", type=int, default=60000)
+parser.add_argument("-e", "--execute", type=str, default="weston-simple-egl -f")
+parser.add_argument("-s", "--seconds", type=int, default=60)
+parser.add_argument("--child", action="store_true")
+args = parser.parse_args()
+
+pattern = re.compile(r".*TIMER\[render\s*\]\s*\S*:\s*([0-9.]+)ms \(\s*([0-9.]+)ms max\),\s*([0-9.]+)Hz")
+
+
+def run_child() -> None:
+    from pywm import PyWM, PyWMView, PyWMDownstreamState, PyWMViewDownstreamState
+    from pywm.pywm_view import PyWMViewUpstreamState
+
+    class View(PyWMView['Compositor']):
+        def __init__(self, wm: Compositor, handle: int):
+            PyWMView.__init__(self, wm, handle)
+            self.output = wm.layout[wm.n_views % len(wm.layout)]
+            wm.n_views += 1
+
+        def init(self) -> PyWMViewDownstreamState:
+            if self.up_state is None:
+                return PyWMViewDownstreamState()
+
+            o = self.output
+            res = PyWMViewDownstreamState(self._handle, (o.pos[0] - self.up_state.offset[0], o.pos[1] - self.up_state.offset[1], o.width, o.height), accepts_input=True)
+            res.size = o.width, o.height
+            return res
+
+        def process(self, up_state: PyWMViewUpstreamState) -> PyWMViewDownstreamState:
+            return self.init()
+
+    class Compositor(PyWM[View]):
+        def __init__(self) -> None:
+            outputs: list[dict[str, Any]] = [{
+                'name': "HEADLESS-%d" % (i + 1),
+                'width': args.width,
+                'height': args.height,
+                'mHz': args.mhz,
+                'pos_x': i * args.width,
+                'pos_y': 0
+            } for i in range(args.outputs)]
+            PyWM.__init__(self, View, outputs=outputs, enable_xwayland=False, encourage_csd=False, debug=True)
+            self.n_views = 0
+
+        def process(self) -> PyWMDownstreamState:
+            return PyWMDownstreamState()
+
+        def main(self) -> None:
+            for _ in range(args.outputs):
+                os.system("%s &" % args.execute)
+            time.sleep(args.seconds)
+            self.terminate()
+
+    Compositor().run()
+
+
+def run_parent() -> None:
+    env = dict(os.environ)
+    env["WLR_BACKENDS"] = "headless"
+    env["WLR_HEADLESS_OUTPUTS"] = str(args.outputs)
+    env["WLR_LIBINPUT_NO_DEVICES"] = "1"
+
+    print("Running %d outputs at %dx%d for %ds: %s" % (args.outputs, args.width, args.height, args.seconds, args.execute))
+    proc = subprocess.Popen([sys.executable, __file__, "--child", *sys.argv[1:]], env=env, stderr=subprocess.PIPE, text=True)
+    assert proc.stderr is not None
+
+    windows: list[tuple[float, float, float]] = []
+    for l in proc.stderr:
+        res = pattern.match(l)
+        if res is not None:
+            avg, mx, hz = float(res.group(1)), float(res.group(2)), float(res.group(3))
+            windows += [(avg, mx, hz)]
+            print("  %7.2fms avg, %7.2fms max, %6.2f frames/s, %5.1f%% render load" % (avg, mx, hz, avg * hz / 10.))
+    proc.wait()
+
+    # First window includes startup
+    if len(windows) > 1:
+        windows = windows[1:]
+    if len(windows) == 0:
+        print("No render timings - is DEBUG logging on and did the clients start?")
+        return
+
+    hz = sum(w[2] for w in windows) / len(windows)
+    avg = sum(w[0] * w[2] for w in windows) / sum(w[2] for w in windows) if hz > 0 else 0.
+    mx = max(w[1] for w in windows)
+    print("Total: %.2f frames/s over %d outputs, %.2fms avg (%.2fms max) per frame, %.1f%% render load" % (hz, args.outputs, avg, mx, avg * hz / 10.))
+
+
+if __name__ == '__main__':
+    if args.child:
+        run_child()
+    else:
+        run_parent()
@@ -0,0 +1,255 @@
+/*
+ * Replay benchmark of pointer hit-testing
+ *
+ * Places N views on three headless 2560x1440 outputs and replays a synthetic
+ * pointer motion stream (a random walk at 1000Hz with occasional jumps)
+ * through wm_server_surface_at, which only tests the candidates of the
+ * wm_spatial grid cell under the pointer. The same stream is replayed
+ * through the former walk over all of wm_server::wm_contents, and both
+ * have to hit the same view for every event.
+ *
+ * Views either share their output as workspace (as in a workspace per
+ * output setup), share the whole layout as workspace (as with a single
+ * output, where the grid falls back to the walk over wm_contents) or have
+ * their display box as workspace.
+ *
+ *     meson setup build -Dbenchmarks=enabled && ninja -C build
+ *     ./build/benchmark_surface_at [events]
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <wayland-server.h>
+#include <wlr/backend.h>
+#include <wlr/backend/headless.h>
+#include <wlr/types/wlr_output_layout.h>
+#include <wlr/util/log.h>
+
+#include "wm/wm_server.h"
+#include "wm/wm_layout.h"
+#include "wm/wm_spatial.h"
+#include "wm/wm_content.h"
+#include "wm/wm_view.h"
+#include "wm/wm_util.h"
+
+#define N_OUTPUTS 3
+#define OUTPUT_WIDTH 2560
+#define OUTPUT_HEIGHT 1440
+
+/* Motion events out of which one jumps to a random position */
+#define JUMP_EVERY 1000
+
+static const int counts[] = { 10, 30, 100, 300 };
+
+enum workspace_mode {
+    WORKSPACE_OUTPUT,
+    WORKSPACE_LAYOUT,
+    WORKSPACE_VIEW,
+};
+
+static const char* workspace_mode_names[] = { "output", "layout", "view" };
+
+/* View accepting input on its whole (client) size */
+struct bench_view {
+    struct wm_view super;
+    int width;
+    int height;
+};
+
+static void bench_view_destroy(struct wm_view* super){
+}
+
+static struct wlr_surface* bench_view_surface_at(struct wm_view* super, double at_x, double at_y, double* sx, double* sy){
+    struct bench_view* view = wl_container_of(super, view, super);
+    if(at_x < 0 || at_y < 0 || at_x >= view->width || at_y >= view->height) return NULL;
+
+    *sx = at_x;
+    *sy = at_y;
+
+    /* Only compared, never dereferenced */
+    return (struct wlr_surface*)view;
+}
+
+static void bench_view_get_size(struct wm_view* super, int* width, int* height){
+    struct bench_view* view = wl_container_of(super, view, super);
+    *width = view->width;
+    *height = view->height;
+}
+
+static struct wm_view_vtable bench_view_vtable = {
+    .destroy = bench_view_destroy,
+    .surface_at = bench_view_surface_at,
+    .get_size = bench_view_get_size,
+};
+
+/* wm_server_surface_at before the spatial index */
+static struct wlr_surface* surface_at_linear(struct wm_server* server, double at_x, double at_y){
+    struct wm_content* content;
+    wl_list_for_each(content, &server->wm_contents, link){
+        if(!wm_content_is_view(content)) continue;
+        struct wm_view* view = wm_cast(wm_view, content);
+
+        if(!view->mapped) continue;
+        if(!view->accepts_input) continue;
+
+        if(wm_content_has_workspace(&view->super)){
+            double x, y, w, h;
+            wm_content_get_workspace(&view->super, &x, &y, &w, &h);
+            if(at_x < x) continue;
+            if(at_y < y) continue;
+            if(at_x > x+w) continue;
+            if(at_y > y+h) continue;
+        }
+
+        int width;
+        int height;
+        wm_view_get_size(view, &width, &height);
+
+        if(width <= 0 || height <=0) continue;
+
+        double display_x, display_y, display_width, display_height;
+        wm_content_get_box(content, &display_x, &display_y, &display_width, &display_height);
+
+        double scale_x = display_width/width;
+        double scale_y = display_height/height;
+
+        int view_at_x = round((at_x - display_x) / scale_x);
+        int view_at_y = round((at_y - display_y) / scale_y);
+
+        double sx;
+        double sy;
+        struct wlr_surface* surface = wm_view_surface_at(view, view_at_x, view_at_y, &sx, &sy);
+        if(surface) return surface;
+    }
+
+    return NULL;
+}
+
+static double msec_since(struct timespec start){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start.tv_sec) * 1000. + (now.tv_nsec - start.tv_nsec) / 1000000.;
+}
+
+static void run(struct wm_server* server, int n, enum workspace_mode mode, double* motion, int n_events){
+    struct bench_view* views = calloc(n, sizeof(struct bench_view));
+
+    srand(n);
+    for(int i=0; i<n; i++){
+        struct bench_view* view = &views[i];
+        wm_view_base_init(&view->super, server);
+        view->super.vtable = &bench_view_vtable;
+        view->super.mapped = true;
+
+        int output = i % N_OUTPUTS;
+        view->width = 400 + rand() % 1200;
+        view->height = 300 + rand() % 900;
+        double x = output * OUTPUT_WIDTH + rand() % (OUTPUT_WIDTH - view->width);
+        double y = rand() % (OUTPUT_HEIGHT - view->height);
+
+        wm_content_set_box(&view->super.super, x, y, view->width, view->height);
+        wm_content_set_z_index(&view->super.super, i);
+        switch(mode){
+        case WORKSPACE_OUTPUT:
+            wm_content_set_workspace(&view->super.super, output * OUTPUT_WIDTH, 0, OUTPUT_WIDTH, OUTPUT_HEIGHT);
+            break;
+        case WORKSPACE_LAYOUT:
+            wm_content_set_workspace(&view->super.super, 0, 0, N_OUTPUTS * OUTPUT_WIDTH, OUTPUT_HEIGHT);
+            break;
+        case WORKSPACE_VIEW:
+            wm_content_set_workspace(&view->super.super, x, y, view->width, view->height);
+            break;
+        }
+    }
+    wm_server_update_contents(server);
+
+    struct wlr_surface** hits = calloc(n_events, sizeof(struct wlr_surface*));
+    struct timespec start;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(int i=0; i<n_events; i++){
+        double sx, sy;
+        wm_server_surface_at(server, motion[2*i], motion[2*i + 1], &hits[i], &sx, &sy, NULL, NULL);
+    }
+    double spatial_ms = msec_since(start);
+
+    int mismatches = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(int i=0; i<n_events; i++){
+        if(surface_at_linear(server, motion[2*i], motion[2*i + 1]) != hits[i]) mismatches++;
+    }
+    double linear_ms = msec_since(start);
+
+    printf("%6d %8s %11.1fns %11.1fns\n", n, workspace_mode_names[mode],
+            1000000. * spatial_ms / n_events, 1000000. * linear_ms / n_events);
+    if(mismatches){
+        fprintf(stderr, "N = %d: %d of %d events hit different views\n", n, mismatches, n_events);
+        exit(1);
+    }
+
+    for(int i=0; i<n; i++){
+        wm_content_destroy(&views[i].super.super);
+    }
+    free(views);
+    free(hits);
+}
+
+int main(int argc, char** argv){
+    int n_events = argc > 1 ? atoi(argv[1]) : 1000000;
+    wlr_log_init(WLR_ERROR, NULL);
+
+    /* Outputs are only needed for the bounding box of the layout */
+    struct wl_display* display = wl_display_create();
+    struct wlr_backend* backend = wlr_headless_backend_create(display);
+
+    struct wm_server server = { 0 };
+    struct wm_layout layout = { 0 };
+    struct wm_spatial spatial;
+    wl_list_init(&server.wm_contents);
+    wl_list_init(&layout.wm_outputs);
+    layout.wm_server = &server;
+    layout.wlr_output_layout = wlr_output_layout_create();
+    for(int i=0; i<N_OUTPUTS; i++){
+        struct wlr_output* output = wlr_headless_add_output(backend, OUTPUT_WIDTH, OUTPUT_HEIGHT);
+        wlr_output_layout_add(layout.wlr_output_layout, output, i * OUTPUT_WIDTH, 0);
+    }
+    server.wm_layout = &layout;
+    server.wm_spatial = &spatial;
+    wm_spatial_init(&spatial, &server);
+
+    /* Random walk in layout coordinates */
+    double* motion = calloc(2 * n_events, sizeof(double));
+    srand(0);
+    double x = OUTPUT_WIDTH / 2, y = OUTPUT_HEIGHT / 2;
+    for(int i=0; i<n_events; i++){
+        if(i % JUMP_EVERY == 0){
+            x = rand() % (N_OUTPUTS * OUTPUT_WIDTH);
+            y = rand() % OUTPUT_HEIGHT;
+        }else{
+            x = fmin(fmax(x + rand() % 11 - 5, 0), N_OUTPUTS * OUTPUT_WIDTH - 1);
+            y = fmin(fmax(y + rand() % 11 - 5, 0), OUTPUT_HEIGHT - 1);
+        }
+        motion[2*i] = x;
+        motion[2*i + 1] = y;
+    }
+
+    printf("%d motion events on %d outputs of %dx%d\n", n_events, N_OUTPUTS, OUTPUT_WIDTH, OUTPUT_HEIGHT);
+    printf("%6s %8s %13s %13s\n", "N", "wsp", "spatial", "linear");
+    for(size_t c=0; c<sizeof(counts) / sizeof(counts[0]); c++){
+        run(&server, counts[c], WORKSPACE_OUTPUT, motion, n_events);
+        run(&server, counts[c], WORKSPACE_LAYOUT, motion, n_events);
+        run(&server, counts[c], WORKSPACE_VIEW, motion, n_events);
+    }
+
+    free(motion);
+    wm_spatial_destroy(&spatial);
+    wlr_output_layout_destroy(layout.wlr_output_layout);
+    wlr_backend_destroy(backend);
+    wl_display_destroy(display);
+
+    return 0;
+}
@@ -0,0 +1,177 @@
+/*
+ * Microbenchmark of keeping wm_server::wm_contents ordered by z-index
+ *
+ * For every content count, replays the same stream of frames twice:
+ * - through wm_content_set_z_index and wm_server_update_contents, as the
+ *   python update and handle_frame do
+ * - through the former bubble sort, which ran on every frame
+ * Every CHANGE_EVERY-th frame raises a random content to the top (focus
+ * change), all other frames change nothing.
+ *
+ *     meson setup build -Dbenchmarks=enabled && ninja -C build
+ *     ./build/benchmark_z_order [frames]
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <wayland-server.h>
+
+#include "wm/wm_server.h"
+#include "wm/wm_layout.h"
+#include "wm/wm_content.h"
+
+#define CHANGE_EVERY 10
+
+static const int counts[] = { 10, 30, 100, 300, 1000 };
+
+/* wm_server_update_contents before contents were kept ordered */
+static void bubble_sort_contents(struct wm_server* server){
+    if(server->wm_contents.next == server->wm_contents.prev) return;
+
+    int swapped = 1;
+    do {
+        swapped = 0;
+
+        struct wl_list* cur1 = server->wm_contents.next;
+        struct wl_list* cur2 = cur1->next;
+        for(;cur1 != server->wm_contents.prev;
+                cur1 = cur1->next, cur2 = cur2->next){
+
+            struct wm_content* content1 = wl_container_of(cur1, content1, link);
+            struct wm_content* content2 = wl_container_of(cur2, content2, link);
+
+            if(wm_content_get_z_index(content1)<wm_content_get_z_index(content2)){
+                cur1->prev->next = cur2;
+                cur2->next->prev = cur1;
+
+                cur1->next = cur2->next;
+                cur2->prev = cur1->prev;
+
+                cur2->next = cur1;
+                cur1->prev = cur2;
+
+                cur1 = cur1->prev;
+                cur2 = cur1;
+                swapped = 1;
+            }
+        }
+
+    } while(swapped);
+}
+
+/* Just enough of a server for contents without outputs */
+struct bench {
+    struct wm_server server;
+    struct wm_layout layout;
+    struct wm_content* contents;
+    int n;
+};
+
+static void bench_init(struct bench* bench, int n){
+    *bench = (struct bench){ 0 };
+    wl_list_init(&bench->server.wm_contents);
+    wl_list_init(&bench->layout.wm_outputs);
+    bench->layout.wm_server = &bench->server;
+    bench->server.wm_layout = &bench->layout;
+
+    bench->n = n;
+    bench->contents = calloc(n, sizeof(struct wm_content));
+    for(int i=0; i<n; i++){
+        wm_content_init(&bench->contents[i], &bench->server);
+    }
+}
+
+static void bench_destroy(struct bench* bench){
+    for(int i=0; i<bench->n; i++){
+        wm_content_destroy(&bench->contents[i]);
+    }
+    free(bench->contents);
+}
+
+static double msec_since(struct timespec start){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start.tv_sec) * 1000. + (now.tv_nsec - start.tv_nsec) / 1000000.;
+}
+
+static bool same_order(struct bench* a, struct bench* b){
+    struct wl_list* cur_b = b->server.wm_contents.next;
+    struct wm_content* content;
+    wl_list_for_each(content, &a->server.wm_contents, link){
+        struct wm_content* other = wl_container_of(cur_b, other, link);
+        if(content - a->contents != other - b->contents) return false;
+        cur_b = cur_b->next;
+    }
+    return true;
+}
+
+int main(int argc, char** argv){
+    int n_frames = argc > 1 ? atoi(argv[1]) : 100000;
+
+    printf("%d frames, z-index change every %d frames\n", n_frames, CHANGE_EVERY);
+    printf("%6s %14s %14s\n", "N", "ordered", "bubble sort");
+
+    for(size_t c=0; c<sizeof(counts) / sizeof(counts[0]); c++){
+        int n = counts[c];
+
+        /* Same initial z-indices (distinct, so both orders are unique) and raised contents for both */
+        double* z_indices = calloc(n, sizeof(double));
+        int* raised = calloc(n_frames / CHANGE_EVERY + 1, sizeof(int));
+        srand(n);
+        for(int i=0; i<n; i++){
+            int j = rand() % (i + 1);
+            z_indices[i] = z_indices[j];
+            z_indices[j] = i + 1;
+        }
+        for(int i=0; i<=n_frames / CHANGE_EVERY; i++) raised[i] = rand() % n;
+
+        struct bench ordered;
+        bench_init(&ordered, n);
+        for(int i=0; i<n; i++) wm_content_set_z_index(&ordered.contents[i], z_indices[i]);
+        wm_server_update_contents(&ordered.server);
+
+        struct bench bubble;
+        bench_init(&bubble, n);
+        for(int i=0; i<n; i++) bubble.contents[i].z_index = z_indices[i];
+        bubble_sort_contents(&bubble.server);
+
+        struct timespec start;
+        double top = n + 1;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for(int f=0; f<n_frames; f++){
+            if(f % CHANGE_EVERY == 0){
+                wm_content_set_z_index(&ordered.contents[raised[f / CHANGE_EVERY]], top + f);
+            }
+            wm_server_update_contents(&ordered.server);
+        }
+        double ordered_ms = msec_since(start);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for(int f=0; f<n_frames; f++){
+            if(f % CHANGE_EVERY == 0){
+                bubble.contents[raised[f / CHANGE_EVERY]].z_index = top + f;
+            }
+            bubble_sort_contents(&bubble.server);
+        }
+        double bubble_ms = msec_since(start);
+
+        if(!same_order(&ordered, &bubble)){
+            fprintf(stderr, "N = %d: orders differ\n", n);
+            return 1;
+        }
+
+        printf("%6d %11.3fus %11.3fus\n", n,
+                1000. * ordered_ms / n_frames, 1000. * bubble_ms / n_frames);
+
+        bench_destroy(&ordered);
+        bench_destroy(&bubble);
+        free(z_indices);
+        free(raised);
+    }
+
+    return 0;
+}
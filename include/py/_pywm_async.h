@@ -0,0 +1,25 @@
+#ifndef _PYWM_ASYNC_H
+#define _PYWM_ASYNC_H
+
+#include <Python.h>
+#include <stdbool.h>
+
+/*
+ * Threaded update: python's update runs on its own thread instead of the
+ * compositor's. Each direction is handed over lock-free through a single slot:
+ *  - upstream: view changes collected by the compositor, taken by python
+ *  - downstream: the complete result of one update, applied by the compositor
+ * A slot is only refilled once the other side has taken it, so no (delta)
+ * update is lost. Apart from reconfiguration, the compositor never waits for
+ * the GIL during updates
+ */
+
+/* apply_config is called on the compositor thread with the GIL held */
+void _pywm_async_start(void (*apply_config)(PyObject* config));
+void _pywm_async_stop();
+bool _pywm_async_enabled();
+
+/* Compositor thread: apply a finished update, pass on upstream changes and request the next update */
+void _pywm_async_update();
+
+#endif
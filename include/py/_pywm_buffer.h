@@ -0,0 +1,41 @@
+#ifndef _PYWM_BUFFER_H
+#define _PYWM_BUFFER_H
+
+#include <Python.h>
+#include <stdbool.h>
+
+/*
+ * _pywm.PixelBuffer(width, height): persistent ARGB8888 pixel storage in a
+ * shared memory file, written to by python through the buffer protocol and
+ * passed to the widget texture without intermediate copies
+ */
+struct _pywm_buffer {
+    PyObject_HEAD
+
+    int width;
+    int height;
+    int stride;
+
+    int fd;
+    void* data;
+    size_t size;
+
+    /* Copy read by the compositor thread in threaded mode, see _pywm_buffer_snapshot */
+    void* snapshot;
+    bool snapshot_valid;
+};
+
+extern PyTypeObject _pywm_buffer_type;
+
+static inline bool _pywm_buffer_check(PyObject* obj){
+    return PyObject_TypeCheck(obj, &_pywm_buffer_type);
+}
+
+/*
+ * Copy the rectangle (the whole buffer on first use) into the snapshot and
+ * return it, so python can keep rendering into data while the compositor
+ * uploads. The snapshot must not be in use by the compositor; GIL held
+ */
+const void* _pywm_buffer_snapshot(struct _pywm_buffer* buffer, int x, int y, int width, int height);
+
+#endif
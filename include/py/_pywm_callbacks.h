@@ -22,6 +22,9 @@ struct _pywm_callbacks {
     PyObject* query_destroy_widget;
 
     PyObject* update;
+
+    /* Optional: update all views and widgets in one call */
+    PyObject* update_all;
 };
 
 void _pywm_callbacks_init();
@@ -0,0 +1,58 @@
+#ifndef _PYWM_PACKED_H
+#define _PYWM_PACKED_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * Sequential reader of records packed by python's struct module in standard
+ * mode ("="), i.e. native byte order, 4-byte i, 8-byte q and d, no alignment
+ */
+struct _pywm_packed {
+    const char* data;
+    long size;
+    long pos;
+
+    /* Set on reading past the end */
+    bool error;
+};
+
+static inline void _pywm_packed_init(struct _pywm_packed* packed, const void* data, long size){
+    packed->data = data;
+    packed->size = size;
+    packed->pos = 0;
+    packed->error = false;
+}
+
+static inline void _pywm_packed_read(struct _pywm_packed* packed, void* dest, long n){
+    if(packed->pos + n > packed->size){
+        packed->error = true;
+        packed->pos = packed->size;
+        memset(dest, 0, n);
+        return;
+    }
+
+    memcpy(dest, packed->data + packed->pos, n);
+    packed->pos += n;
+}
+
+static inline int _pywm_packed_int(struct _pywm_packed* packed){
+    int32_t res;
+    _pywm_packed_read(packed, &res, sizeof(res));
+    return res;
+}
+
+static inline long _pywm_packed_long(struct _pywm_packed* packed){
+    int64_t res;
+    _pywm_packed_read(packed, &res, sizeof(res));
+    return res;
+}
+
+static inline double _pywm_packed_double(struct _pywm_packed* packed){
+    double res;
+    _pywm_packed_read(packed, &res, sizeof(res));
+    return res;
+}
+
+#endif
@@ -1,19 +1,63 @@
 #ifndef _PYWM_VIEW_H
 #define _PYWM_VIEW_H
 
+#include <Python.h>
+#include <stdbool.h>
+
 struct wm_view;
 
 struct _pywm_view {
     long handle;
     struct wm_view* view;
 
-    int update_cnt;
+    /* Upstream state last passed to python - only changes are passed on */
+    struct {
+        bool valid;
+        int width, height;
+        bool mapped;
+        bool floating, focused, fullscreen, maximized, resizing, inhibiting_idle;
+        int* size_constraints;
+        int n_size_constraints;
+        int offset_x, offset_y;
+        bool shows_csd;
+        int fixed_output_key;
+    } upstream;
 
     struct _pywm_view* next_view;
 };
 
 void _pywm_view_init(struct _pywm_view* _view, struct wm_view* view);
 
+/*
+ * Upstream changes of one view since the last call, collected without touching
+ * python objects; changed holds the WM_VIEW_DIRTY_* flags of the parts set
+ */
+struct _pywm_view_changes {
+    long handle;
+    unsigned int changed;
+
+    long parent_handle;
+    bool xwayland;
+    int pid;
+    char* app_id;
+    char* role;
+    char* title;
+
+    int width, height;
+    bool mapped;
+    bool floating, focused, fullscreen, maximized, resizing, inhibiting_idle;
+    int* size_constraints;
+    int n_size_constraints;
+    int offset_x, offset_y;
+    bool shows_csd;
+    int fixed_output_key;
+};
+
+/* Returns false if nothing changed; call _pywm_view_changes_finish in any case */
+bool _pywm_view_collect_changes(struct _pywm_view* view, struct _pywm_view_changes* changes);
+PyObject* _pywm_view_changes_build_args(struct _pywm_view_changes* changes);
+void _pywm_view_changes_finish(struct _pywm_view_changes* changes);
+
 void _pywm_view_update(struct _pywm_view* view);
 
 struct _pywm_views {
@@ -27,4 +71,16 @@ long _pywm_views_remove(struct wm_view* view);
 void _pywm_views_update();
 void _pywm_views_update_single(struct wm_view* view);
 
+/* Batched update: list of update_view arguments (handle first) of all views with upstream changes */
+PyObject* _pywm_views_update_args();
+/* Same as _pywm_views_update_args without python objects; returns number of entries in *changes */
+int _pywm_views_collect_changes(struct _pywm_view_changes** changes, int* size_changes);
+/* Apply the packed downstream states returned for _pywm_views_update_args; false on malformed data */
+bool _pywm_views_update_apply(const void* data, long size);
+
+/* Changes collected for handle did not reach python - pass its full upstream state next time */
+void _pywm_views_invalidate_upstream(long handle);
+/* Same for every handle in a list returned by _pywm_views_update_args */
+void _pywm_views_invalidate_args(PyObject* list);
+
 #endif
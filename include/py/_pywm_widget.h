@@ -1,9 +1,13 @@
 #ifndef _PYWM_WIDGET_H
 #define _PYWM_WIDGET_H
 
+#include <Python.h>
+#include <stdbool.h>
+
 struct wm_widget;
 struct wm_composite;
 struct wm_content;
+struct _pywm_buffer;
 
 struct _pywm_widget {
     long handle;
@@ -14,20 +18,66 @@ struct _pywm_widget {
     struct wm_content* super;
 };
 
-void _pywm_widget_init(struct _pywm_widget* _widget, struct wm_widget* widget, struct wm_composite* composite);
+void _pywm_widget_init(struct _pywm_widget* _widget, struct wm_widget* widget, struct wm_composite* composite, long handle);
 
 void _pywm_widget_update(struct _pywm_widget* widget);
 
+/*
+ * Pixels and primitive of a widget update parsed from the python objects; the
+ * pixel data is kept alive by pixels_ref. Parse and release need the GIL, apply
+ * does not (and passes the primitive on to the widget)
+ */
+struct _pywm_widget_payload {
+    long handle;
+
+    PyObject* pixels_ref;
+    struct _pywm_buffer* buffer;  /* If data points into a PixelBuffer */
+    const void* data;
+    int stride, width, height;
+    bool partial;
+    int region_x, region_y, region_width, region_height;
+
+    char* primitive;
+    int n_params_int;
+    int* params_int;
+    int n_params_float;
+    float* params_float;
+};
+
+bool _pywm_widget_payload_parse(struct _pywm_widget_payload* payload, long handle, PyObject* pixels, PyObject* primitive);
+void _pywm_widget_payload_apply(struct _pywm_widget* widget, struct _pywm_widget_payload* payload);
+void _pywm_widget_payload_release(struct _pywm_widget_payload* payload);
+
+/*
+ * Point data at a copy of the changed part of a PixelBuffer, so the payload can
+ * be applied without the GIL while python renders into the buffer again
+ */
+bool _pywm_widget_payload_snapshot(struct _pywm_widget_payload* payload);
+
 struct _pywm_widgets {
     struct _pywm_widget* first_widget;
 };
 
 void _pywm_widgets_init();
-long _pywm_widgets_add(struct wm_widget* widget, struct wm_composite* composite);
+long _pywm_widgets_add(struct wm_widget* widget, struct wm_composite* composite, long handle);
 long _pywm_widgets_get_handle(struct wm_content* content);
 long _pywm_widgets_remove(struct wm_content* content);
 void _pywm_widgets_update();
 
+/* Process pending widget creation / destruction */
+void _pywm_widgets_update_structure();
+
+/* Split up _pywm_widgets_update_structure: query python (GIL), then create / destroy (no GIL); handles <= 0 are ignored */
+void _pywm_widgets_query_structure(long* destroy_handle, long* new_handle, int* new_type);
+void _pywm_widgets_apply_structure(long destroy_handle, long new_handle, int new_type);
+
+/* Batched update: apply the packed downstream states of changed widgets and their (handle, pixels, primitive) payloads */
+void _pywm_widgets_update_apply(const void* data, long size, PyObject* payloads);
+
+/* Parts of _pywm_widgets_update_apply not touching python objects */
+bool _pywm_widgets_update_apply_states(const void* data, long size);
+void _pywm_widgets_apply_payload(struct _pywm_widget_payload* payload);
+
 struct _pywm_widget* _pywm_widgets_container_from_handle(long handle);
 struct wm_content* _pywm_widgets_from_handle(long handle);
 
@@ -30,6 +30,12 @@ void wm_composite_set_type(struct wm_composite* comp, const char* type, int n_pa
 
 void wm_composite_on_damage_below(struct wm_composite* comp, struct wm_output* output, struct wm_content* from, pixman_region32_t* damage);
 bool wm_content_is_composite(struct wm_content* content);
+
+/*
+ * All composites ordered like wm_server::wm_contents (highest z-index first);
+ * *result is valid until the order of wm_contents changes
+ */
+int wm_composite_list(struct wm_server* server, struct wm_composite*** result);
 void wm_composite_apply(struct wm_composite* composite, struct wm_output* output, pixman_region32_t* damage, struct timespec now);
 
 struct wm_compose_chain {
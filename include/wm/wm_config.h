@@ -28,6 +28,12 @@ struct wm_config_output {
     int pos_y;
 
     enum wl_output_transform transform;
+
+    /*
+     * Unit: ms, render this long before the next vblank instead of directly
+     * upon the frame event; 0 to disable, < 0 to estimate from recent frames
+     */
+    int max_render_time;
 };
 
 struct wm_config {
@@ -57,6 +63,12 @@ struct wm_config {
     bool tap_to_click;
     bool natural_scroll;
 
+    /* Put a fullscreen xdg view's buffer on the output directly if nothing else is visible (not Xwayland) */
+    bool direct_scanout;
+
+    /* Record per-frame timestamps on every output, see wm_output::frame_timings */
+    bool frame_timing;
+
     bool debug;
 };
 
@@ -67,7 +79,8 @@ void wm_config_set_xcursor_theme(struct wm_config* config, const char* xcursor_t
 void wm_config_set_xcursor_size(struct wm_config* config, int xcursor_size);
 void wm_config_add_output(struct wm_config *config, const char *name,
                           double scale, int width, int height, int mHz,
-                          int pos_x, int pos_y, enum wl_output_transform transform);
+                          int pos_x, int pos_y, enum wl_output_transform transform,
+                          int max_render_time);
 struct wm_config_output *wm_config_find_output(struct wm_config *config,
                                                const char *name);
 void wm_config_destroy(struct wm_config *config);
@@ -40,6 +40,16 @@ struct wm_content {
     double z_index;
     double opacity;
 
+    /* Position in wm_server::wm_contents - valid after wm_server_update_contents */
+    int z_order;
+
+    /* Cells of wm_spatial this content is registered in (none if x1 < x0) */
+    bool spatial_unbounded;
+    int spatial_x0;
+    int spatial_y0;
+    int spatial_x1;
+    int spatial_y1;
+
     /* Accepts input and is displayed clearly during lock - careful */
     bool lock_enabled;
 };
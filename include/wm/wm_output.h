@@ -1,6 +1,7 @@
 #ifndef WM_OUTPUT_H
 #define WM_OUTPUT_H
 
+#include <stdint.h>
 #include <wayland-server.h>
 #include <wlr/types/wlr_output.h>
 #include <wlr/types/wlr_damage_ring.h>
@@ -9,6 +10,57 @@
 struct wm_layout;
 struct wm_renderer_buffers;
 
+/* Number of recent render times used to estimate the render deadline */
+#define WM_OUTPUT_RENDER_TIMES 16
+
+/* Unit: us, safety margin added to estimated render times */
+#define WM_OUTPUT_RENDER_MARGIN 1500
+
+/* Number of recent frames kept in wm_frame_timings */
+#define WM_OUTPUT_FRAME_TIMINGS 256
+
+enum wm_frame_timing_event {
+    WM_FRAME_TIMING_DAMAGE,          /* first damage since last frame */
+    WM_FRAME_TIMING_SCHEDULE_FRAME,  /* first frame scheduled since last frame */
+    WM_FRAME_TIMING_RENDER_BEGIN,
+    WM_FRAME_TIMING_RENDER_END,      /* including commit and frame done events */
+    WM_FRAME_TIMING_COMMIT,          /* buffer committed to the output */
+    WM_FRAME_TIMING_PRESENT,         /* as reported by the backend */
+    WM_FRAME_TIMING_PY_START,        /* first python update since last frame */
+    WM_FRAME_TIMING_PY_FINISH,       /* last python update since last frame */
+
+    WM_FRAME_TIMING_N
+};
+
+/*
+ * Timestamps of one frame - handed to python as is (struct "=Q8q"), so keep
+ * free of padding
+ */
+struct wm_frame_timing {
+    uint64_t seq;
+
+    /* Unit: ns, CLOCK_MONOTONIC; 0 if the event did not occur */
+    int64_t t[WM_FRAME_TIMING_N];
+};
+
+/*
+ * Recent frames of one output; owned by wm_server::frame_timings and only
+ * accessed with wm_server::frame_timings_mutex held, so it can be read from
+ * any thread
+ */
+struct wm_frame_timings {
+    struct wl_list link;  // wm_server::frame_timings
+
+    int output_key;
+
+    /* Frames published so far - slot n % WM_OUTPUT_FRAME_TIMINGS is next */
+    uint64_t n;
+    struct wm_frame_timing frames[WM_OUTPUT_FRAME_TIMINGS];
+};
+
+/* Copy the frames to dest (WM_OUTPUT_FRAME_TIMINGS long), oldest first; returns their number */
+int wm_frame_timings_copy(struct wm_frame_timings* timings, struct wm_frame_timing* dest);
+
 struct wm_output {
     struct wm_server* wm_server;
     struct wm_layout* wm_layout;
@@ -28,10 +80,36 @@ struct wm_output {
     struct wl_listener damage;
     struct wl_listener frame;
     struct wl_listener needs_frame;
+    struct wl_listener present;
 
     bool expecting_frame;
+
+    /* Last frame has been a client buffer put on the output directly, see wm_config::direct_scanout */
+    bool scanout;
     struct timespec last_frame;
 
+    /*
+     * Render deadline - see wm_config_output::max_render_time; the frame is
+     * rendered by render_timer, scheduled relative to the last presentation
+     */
+    int max_render_time;
+    struct wl_event_source* render_timer;
+    struct timespec last_presentation;
+    int refresh_nsec;
+
+    /* Unit: us, ring buffer of recent render times */
+    long render_times[WM_OUTPUT_RENDER_TIMES];
+    int render_times_pos;
+
+    /*
+     * Only recorded if wm_config::frame_timing is set. A committed frame waits
+     * in frame_timing_presenting for its present event (or the next commit)
+     * before it is published to frame_timings
+     */
+    struct wm_frame_timings* frame_timings;
+    struct wm_frame_timing frame_timing;  /* Frame being recorded */
+    struct wm_frame_timing frame_timing_presenting;
+
 #if WM_CUSTOM_RENDERER
     struct wm_renderer_buffers* renderer_buffers;
 #endif
@@ -42,6 +120,9 @@ void wm_output_destroy(struct wm_output* output);
 
 void wm_output_reconfigure(struct wm_output* output);
 
+/* Record event for the upcoming frame; cheap no-op unless wm_config::frame_timing */
+void wm_output_frame_timing(struct wm_output* output, enum wm_frame_timing_event event);
+
 
 /*
  * Override name of next output to be initialised
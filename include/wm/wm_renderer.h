@@ -13,6 +13,8 @@ struct wm_output;
 struct wm_renderer;
 
 #include <GLES3/gl32.h>
+#include "wm/wm_shader_cache.h"
+
 struct wm_renderer_texture_shader {
     GLuint shader;
 
@@ -42,6 +44,13 @@ struct wm_renderer_texture_shader {
 struct wm_renderer_texture_shaders {
     const char* name;
 
+    /* Sources are registered at startup, programs only linked once selected */
+    bool linked;
+    const GLchar* vert_src;
+    const GLchar* frag_src_rgba;
+    const GLchar* frag_src_rgbx;
+    const GLchar* frag_src_ext;
+
     struct wm_renderer_texture_shader rgba;
     struct wm_renderer_texture_shader rgbx;
     struct wm_renderer_texture_shader ext;
@@ -51,6 +60,11 @@ struct wm_renderer_primitive_shader {
     GLuint shader;
     const char* name;
 
+    /* Sources are registered at startup, program only linked once selected */
+    bool linked;
+    const GLchar* vert_src;
+    const GLchar* frag_src;
+
     /* Basic parameters */
     GLint proj;
     GLint alpha;
@@ -151,6 +165,8 @@ struct wm_renderer {
     struct wm_renderer_texture_shaders* texture_shaders_selected;
     struct wm_renderer_primitive_shader* primitive_shader_selected;
 
+    struct wm_shader_cache shader_cache;
+
     unsigned int selected_buffer;
 #endif
 };
@@ -175,8 +191,10 @@ void wm_renderer_add_primitive_shader(struct wm_renderer* renderer, const char*
 #endif
 
 void wm_renderer_select_texture_shaders(struct wm_renderer* renderer, const char* name);
-void wm_renderer_select_primitive_shader(struct wm_renderer* renderer, const char* name);
-bool wm_renderer_check_primitive_params(struct wm_renderer* renderer, int n_int, int n_float);
+/* Resolve name to a handle (falling back to the default shader) once; -1 if there are none */
+int wm_renderer_get_primitive_shader(struct wm_renderer* renderer, const char* name);
+void wm_renderer_select_primitive_shader(struct wm_renderer* renderer, int shader);
+bool wm_renderer_check_primitive_params(struct wm_renderer* renderer, int shader, int n_int, int n_float);
 
 void wm_renderer_to_buffer(struct wm_renderer* renderer, unsigned int buffer);
 
@@ -1,6 +1,7 @@
 #ifndef WM_SERVER_H
 #define WM_SERVER_H
 
+#include <pthread.h>
 #include <time.h>
 #include <wayland-server.h>
 #include <wlr/backend.h>
@@ -19,6 +20,9 @@ struct wm_layout;
 struct wm_renderer;
 struct wm_output;
 struct wm_idle_inhibit;
+struct wm_spatial;
+struct wm_composite;
+struct wm_frame_timings;
 
 struct wm_server{
     struct wm_config* wm_config;
@@ -51,10 +55,28 @@ struct wm_server{
     struct wm_seat* wm_seat;
     struct wm_layout* wm_layout;
     struct wm_idle_inhibit* wm_idle_inhibit;
+    struct wm_spatial* wm_spatial;
 
-    /* Sorted by z-index (highest first) */
+    /*
+     * Sorted by z-index (highest first) - kept in order by wm_content_set_z_index.
+     * Views stay linked while unmapped; check wm_view::mapped where it matters
+     */
     struct wl_list wm_contents;  // wm_content::link
 
+    /* Incremented whenever the order of wm_contents changes */
+    unsigned long wm_contents_generation;
+    unsigned long wm_contents_sorted_generation;
+
+    /* Composites in wm_contents order - see wm_composite_list */
+    struct wm_composite** wm_composites;
+    int n_composites;
+    int size_composites;
+    unsigned long wm_composites_generation;
+
+    /* Recent frames of all outputs, readable from any thread - see wm_server_frame_timings_foreach */
+    struct wl_list frame_timings;  // wm_frame_timings::link
+    pthread_mutex_t frame_timings_mutex;
+
     struct wl_listener new_input;
     struct wl_listener new_virtual_pointer;
     struct wl_listener new_virtual_keyboard;
@@ -79,6 +101,10 @@ void wm_server_surface_at(struct wm_server* server, double at_x, double at_y,
         struct wlr_surface** result, double* result_sx, double* result_sy, double* result_scale_x, double* result_scale_y);
 struct wm_view* wm_server_view_for_surface(struct wm_server* server, struct wlr_surface* surface);
 
+/*
+ * Ensure wm_contents is sorted by z-index; no-op unless the order changed
+ * since the last call
+ */
 void wm_server_update_contents(struct wm_server* server);
 
 void wm_server_open_virtual_output(struct wm_server* server, const char* name);
@@ -95,6 +121,12 @@ bool wm_server_is_locked(struct wm_server* server);
 
 void wm_server_printf(FILE* file, struct wm_server* server);
 
+/*
+ * Call f for the wm_frame_timings of every output with frame_timings_mutex
+ * held; any thread
+ */
+void wm_server_frame_timings_foreach(struct wm_server* server, void (*f)(struct wm_frame_timings* timings, void* data), void* data);
+
 /* Update after new wm_config key-vals where suitable */
 void wm_server_reconfigure(struct wm_server* server);
 
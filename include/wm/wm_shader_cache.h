@@ -0,0 +1,39 @@
+#ifndef WM_SHADER_CACHE_H
+#define WM_SHADER_CACHE_H
+
+#ifdef WM_CUSTOM_RENDERER
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <GLES3/gl32.h>
+
+/*
+ * On-disk cache of linked program binaries in $XDG_CACHE_HOME/pywm/shaders
+ *
+ * Entries are keyed by a hash of both shader sources and the GL vendor,
+ * renderer and version strings, so a source or driver change simply misses.
+ * Entries the driver refuses to load are removed. Set PYWM_SHADER_CACHE=0 to
+ * disable the cache
+ */
+struct wm_shader_cache {
+    bool enabled;
+    char dir[PATH_MAX];
+    uint64_t driver_hash;
+
+    int n_hits;
+    int n_misses;
+};
+
+/* Requires a current GL context */
+void wm_shader_cache_init(struct wm_shader_cache* cache);
+
+/* Returns a linked program or 0 if not cached */
+GLuint wm_shader_cache_load(struct wm_shader_cache* cache, const GLchar* vert_src, const GLchar* frag_src);
+
+/* Store prog, which must have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set */
+void wm_shader_cache_store(struct wm_shader_cache* cache, GLuint prog, const GLchar* vert_src, const GLchar* frag_src);
+
+#endif
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef WM_SPATIAL_H
+#define WM_SPATIAL_H
+
+#include <stdbool.h>
+
+struct wm_server;
+struct wm_content;
+
+/* Edge length of one grid cell in layout coordinates */
+#define WM_SPATIAL_CELL_SIZE 256
+
+/* wm_spatial_candidates_at gives up once this many eighths of all views are candidates */
+#define WM_SPATIAL_LINEAR_EIGHTHS 7
+
+struct wm_spatial_cell {
+    struct wm_content** contents;
+    int n_contents;
+    int size_contents;
+
+    /* contents is ordered by wm_content::z_order unless dirty or generation is outdated */
+    bool dirty;
+    unsigned long generation;
+};
+
+/*
+ * Uniform grid over the bounding box of the output layout used to find the
+ * views which possibly receive input at a given point
+ *
+ * A view can only accept input inside its workspace (if set), which is
+ * therefore the box a view is registered with. The display box is no bound
+ * (popups, xwayland children and CSD input regions reach outside of it), so
+ * views without workspace are kept in unbounded and are candidates everywhere.
+ */
+struct wm_spatial {
+    struct wm_server* wm_server;
+
+    double x;
+    double y;
+    int cols;
+    int rows;
+    struct wm_spatial_cell* cells;
+
+    struct wm_spatial_cell unbounded;
+
+    /* Number of registered views */
+    int n_views;
+
+    /* Result buffer of wm_spatial_candidates_at */
+    struct wm_content** candidates;
+    int size_candidates;
+};
+
+void wm_spatial_init(struct wm_spatial* spatial, struct wm_server* server);
+void wm_spatial_destroy(struct wm_spatial* spatial);
+
+/* Resize grid to the output layout and re-register all views */
+void wm_spatial_reconfigure(struct wm_spatial* spatial);
+
+/* (Re-)register content after its workspace changed; only views are indexed */
+void wm_spatial_update(struct wm_spatial* spatial, struct wm_content* content);
+void wm_spatial_remove(struct wm_spatial* spatial, struct wm_content* content);
+
+/*
+ * Views possibly accepting input at x, y (layout coordinates), ordered like
+ * wm_server::wm_contents (highest z-index first). *result is valid until the
+ * next call
+ *
+ * Returns -1 if (almost) every view is a candidate at x, y, e.g. if all of
+ * them share the output as workspace. The caller then rather walks
+ * wm_server::wm_contents, which is ordered already
+ */
+int wm_spatial_candidates_at(struct wm_spatial* spatial, double x, double y, struct wm_content*** result);
+
+#endif
@@ -6,12 +6,47 @@
 #include <wlr/types/wlr_xdg_shell.h>
 #include <wlr/types/wlr_xdg_decoration_v1.h>
 #include <wlr/util/box.h>
+#include <wlr/util/addon.h>
 
 #include "wm_content.h"
 
 struct wm_seat;
+struct wm_view;
 struct wm_view_vtable;
 
+/*
+ * Associates a wlr_surface (root, subsurface, popup, ...) with the view it belongs to,
+ * see wm_server_view_for_surface. Embedded into the structs tracking these surfaces
+ */
+struct wm_view_surface {
+    struct wl_list link; // wm_view::surfaces
+
+    /* NULL if not associated */
+    struct wm_view* view;
+    struct wlr_addon addon;
+};
+
+/* view == NULL or surface == NULL leaves view_surface unassociated */
+void wm_view_surface_init(struct wm_view_surface* view_surface, struct wm_view* view, struct wlr_surface* surface);
+void wm_view_surface_finish(struct wm_view_surface* view_surface);
+
+/*
+ * Parts of the upstream state (as passed to python) which possibly changed
+ * since they have last been passed, see wm_view::dirty
+ */
+enum wm_view_dirty {
+    WM_VIEW_DIRTY_INFO = 1 << 0,            /* parent, pid, title, app_id, role */
+    WM_VIEW_DIRTY_SIZE = 1 << 1,
+    WM_VIEW_DIRTY_MAPPED = 1 << 2,
+    WM_VIEW_DIRTY_STATE = 1 << 3,           /* floating, focused, fullscreen, maximized, resizing, inhibiting_idle */
+    WM_VIEW_DIRTY_SIZE_CONSTRAINTS = 1 << 4,
+    WM_VIEW_DIRTY_OFFSET = 1 << 5,
+    WM_VIEW_DIRTY_CSD = 1 << 6,
+    WM_VIEW_DIRTY_OUTPUT = 1 << 7,
+
+    WM_VIEW_DIRTY_ALL = (1 << 8) - 1,
+};
+
 typedef void (*wm_surface_iterator_func_t)(struct wlr_surface *surface,
 	int sx, int sy, bool constrained, void *data);
 
@@ -24,9 +59,15 @@ struct wm_view {
 
     bool accepts_input;
 
+    /* Surfaces associated with this view */
+    struct wl_list surfaces; // wm_view_surface::link
+
     /* defaults to false; if by means of wlr_server_decoration or wlr_toplevel_decoration we know the view is decorated: true */
     bool shows_csd;
 
+    /* enum wm_view_dirty - set by the handlers and setters, cleared once passed on to python */
+    unsigned int dirty;
+
     /* Server-side determined states - stored from setter */
     bool floating;
     bool focused;
@@ -37,10 +78,18 @@ struct wm_view {
 
 void wm_view_base_init(struct wm_view* view, struct wm_server* server);
 
+/* Constant time lookup of the view a surface belongs to */
+struct wm_view* wm_view_for_surface(struct wm_server* server, struct wlr_surface* surface);
+
 void wm_view_set_inhibiting_idle(struct wm_view* view, bool inhibiting_idle);
 bool wm_view_is_inhibiting_idle(struct wm_view* view);
 
 bool wm_content_is_view(struct wm_content* content);
+
+static inline void wm_view_set_dirty(struct wm_view* view, unsigned int dirty){
+    view->dirty |= dirty;
+}
+
 bool wm_view_shows_csd(struct wm_view* view);
 
 struct wm_view_vtable {
@@ -98,26 +147,31 @@ static inline void wm_view_focus(struct wm_view* view, struct wm_seat* seat){
 
 static inline void wm_view_set_floating(struct wm_view* view, bool floating){
     view->floating = floating;
+    view->dirty |= WM_VIEW_DIRTY_STATE;
     (*view->vtable->set_floating)(view, floating);
 }
 
 static inline void wm_view_set_resizing(struct wm_view* view, bool resizing){
     view->resizing = resizing;
+    view->dirty |= WM_VIEW_DIRTY_STATE;
     (*view->vtable->set_resizing)(view, resizing);
 }
 
 static inline void wm_view_set_fullscreen(struct wm_view* view, bool fullscreen){
     view->fullscreen = fullscreen;
+    view->dirty |= WM_VIEW_DIRTY_STATE;
     (*view->vtable->set_fullscreen)(view, fullscreen);
 }
 
 static inline void wm_view_set_maximized(struct wm_view* view, bool maximized){
     view->maximized = maximized;
+    view->dirty |= WM_VIEW_DIRTY_STATE;
     (*view->vtable->set_maximized)(view, maximized);
 }
 
 static inline void wm_view_set_activated(struct wm_view* view, bool activated){
     view->focused = activated;
+    view->dirty |= WM_VIEW_DIRTY_STATE;
     (*view->vtable->set_activated)(view, activated);
 }
 
@@ -14,6 +14,7 @@ struct wm_layer_subsurface {
     struct wm_view_layer* root;
 
     struct wlr_subsurface* wlr_subsurface;
+    struct wm_view_surface view_surface;
 
     struct wl_list subsurfaces;
 
@@ -34,6 +35,7 @@ struct wm_popup_layer {
     struct wm_view_layer* root;
 
     struct wlr_xdg_popup* wlr_xdg_popup;
+    struct wm_view_surface view_surface;
 
     struct wl_list popups;
     struct wl_list subsurfaces;
@@ -53,6 +55,7 @@ struct wm_view_layer {
     struct wm_view super;
 
     struct wlr_layer_surface_v1* wlr_layer_surface;
+    struct wm_view_surface view_surface;
 
     int width;
     int height;
@@ -15,6 +15,7 @@ struct wm_xdg_subsurface {
     struct wm_view_xdg* toplevel;
 
     struct wlr_subsurface* wlr_subsurface;
+    struct wm_view_surface view_surface;
 
     struct wl_list subsurfaces;
 
@@ -35,6 +36,7 @@ struct wm_popup_xdg {
     struct wm_view_xdg* toplevel;
 
     struct wlr_xdg_popup* wlr_xdg_popup;
+    struct wm_view_surface view_surface;
 
     struct wl_list popups;
     struct wl_list subsurfaces;
@@ -54,6 +56,7 @@ struct wm_view_xdg {
     struct wm_view super;
 
     struct wlr_xdg_surface* wlr_xdg_surface;
+    struct wm_view_surface view_surface;
     struct wlr_xdg_toplevel_decoration_v1* wlr_deco;
     struct wlr_server_decoration* wlr_server_deco;
 
@@ -93,6 +96,9 @@ struct wm_view_xdg {
     struct wl_listener request_maximize;
     struct wl_listener request_minimize;
     struct wl_listener request_show_window_menu;
+    struct wl_listener set_title;
+    struct wl_listener set_app_id;
+    struct wl_listener set_parent;
 };
 
 void wm_view_xdg_init(struct wm_view_xdg* view, struct wm_server* server, struct wlr_xdg_surface* surface);
@@ -14,6 +14,8 @@ struct wm_view_xwayland_child {
     struct wm_view_xwayland* parent;
 
     struct wlr_xwayland_surface* wlr_xwayland_surface;
+    /* Associated while mapped */
+    struct wm_view_surface view_surface;
 
     bool mapped;
 
@@ -32,6 +34,8 @@ struct wm_view_xwayland {
     struct wm_view super;
 
     struct wlr_xwayland_surface* wlr_xwayland_surface;
+    /* Associated while mapped */
+    struct wm_view_surface view_surface;
 
     struct wl_list children;
 
@@ -42,6 +46,8 @@ struct wm_view_xwayland {
     struct wl_listener request_configure;
     struct wl_listener set_parent;
     struct wl_listener set_pid;
+    struct wl_listener set_title;
+    struct wl_listener set_class;
     struct wl_listener map;
     struct wl_listener unmap;
     struct wl_listener destroy;
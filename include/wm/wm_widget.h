@@ -21,6 +21,10 @@ struct wm_widget {
     struct wlr_texture* wlr_texture;
     struct {
         char* name;
+
+        /* Resolved from name, -1 if invalid - see wm_renderer_get_primitive_shader */
+        int shader;
+
         int n_params_int;
         int* params_int;
         int n_params_float;
@@ -30,8 +34,16 @@ struct wm_widget {
 
 void wm_widget_init(struct wm_widget* widget, struct wm_server* server);
 
+/* data is only read during the call; the texture is updated in place if the size is unchanged */
 void wm_widget_set_pixels(struct wm_widget* widget, uint32_t format, uint32_t stride, uint32_t width, uint32_t height, const void* data);
 
+/*
+ * Like wm_widget_set_pixels (data is the full image), but only the given rectangle (in pixels) has changed:
+ * If the size is unchanged, only this rectangle is uploaded and damaged
+ */
+void wm_widget_set_pixels_region(struct wm_widget* widget, uint32_t format, uint32_t stride, uint32_t width, uint32_t height, const void* data,
+        int region_x, int region_y, int region_width, int region_height);
+
 void wm_widget_set_primitive(struct wm_widget* widget, char* name, int n_params_int, int* params_int, int n_params_float, float* params_float);
 
 #endif
@@ -3,6 +3,7 @@ from .pywm import (
     PyWMModifiers,
     PyWMOutput,
     PyWMDownstreamState,
+    PyWMFrameTiming,
     PYWM_MOD_SHIFT,
     PYWM_MOD_CAPS,
     PYWM_MOD_CTRL,
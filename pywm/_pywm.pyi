@@ -4,3 +4,10 @@ def run(**kwargs: dict[str, Any]) -> None: ...
 def register(func: str, call: Callable[..., Any]) -> None: ...
 def damage(code: int) -> None: ...
 def debug_performance(key: str) -> None: ...
+def frame_timings() -> list[tuple[int, bytes]]: ...
+
+class PixelBuffer:
+    width: int
+    height: int
+    stride: int
+    def __init__(self, width: int, height: int) -> None: ...
@@ -3,6 +3,7 @@ from typing import Callable, Optional, Any, TypeVar, Generic, Union, cast
 
 from abc import abstractmethod
 import logging
+import struct
 import time
 from threading import Thread, Lock
 
@@ -13,7 +14,8 @@ from .damage_tracked import DamageTracked
 from ._pywm import (
     run,
     register,
-    damage
+    damage,
+    frame_timings
 )
 
 PYWM_MOD_SHIFT = 1
@@ -39,6 +41,22 @@ PYWM_TRANSFORM_FLIPPED_270 = 7
 
 logger: logging.Logger = logging.getLogger(__name__)
 
+"""
+Record layouts of the update_all return, see _pywm_views_update_apply / _pywm_widgets_update_apply
+    view: handle, valid, box, mask, opacity, corner_radius, z_index, accepts_input, lock_enabled, floating,
+        size, focus, fullscreen, maximized, resizing, close, fixed_output, workspace
+    widget: handle, valid, lock_enabled, box, mask, output, opacity, corner_radius, z_index, workspace
+"""
+_PACKED_VIEW = struct.Struct("=qi4d4d3d3i2i6i4d")
+_PACKED_WIDGET = struct.Struct("=qii4d4di3d4d")
+
+"""
+Record layout of frame_timings, see struct wm_frame_timing
+    seq, then ns CLOCK_MONOTONIC (0 if not occurred) of damage, schedule_frame, render_begin, render_end,
+        commit, present, py_start, py_finish
+"""
+_PACKED_FRAME_TIMING = struct.Struct("=Q8q")
+
 class PyWMModifiers:
     def __init__(self, modifiers: int) -> None:
         self.shift = bool(modifiers & PYWM_MOD_SHIFT)
@@ -113,6 +131,33 @@ class PyWMModifiers:
             "2" if self.mod2 else "" +
             "3" if self.mod3 else "")
 
+class PyWMFrameTiming:
+    def __init__(self, seq: int, damage: int, schedule_frame: int, render_begin: int, render_end: int,
+                 commit: int, present: int, py_start: int, py_finish: int) -> None:
+        self.seq = seq
+        self.damage = damage
+        self.schedule_frame = schedule_frame
+        self.render_begin = render_begin
+        self.render_end = render_end
+        self.commit = commit
+        self.present = present
+        self.py_start = py_start
+        self.py_finish = py_finish
+
+    def render_time(self) -> int:
+        return self.render_end - self.render_begin
+
+    def latency(self) -> Optional[int]:
+        # Time from first damage to presentation, if both have been recorded
+        if self.damage == 0 or self.present == 0:
+            return None
+        return self.present - self.damage
+
+    def __str__(self) -> str:
+        return "Frame(%d) render=%.3fms latency=%s" % (
+            self.seq, self.render_time() / 1e6,
+            "-" if self.latency() is None else "%.3fms" % (cast(int, self.latency()) / 1e6))
+
 class PyWMDownstreamState:
     def __init__(self, lock_perc: float=0.0) -> None:
         self.lock_perc = lock_perc
@@ -205,6 +250,7 @@ class PyWM(Generic[ViewT], DamageTracked):
         register("query_destroy_widget", self._query_destroy_widget)
 
         register("update", self._update)
+        register("update_all", self._update_all)
 
         self._view_class = view_class
 
@@ -332,6 +378,12 @@ class PyWM(Generic[ViewT], DamageTracked):
     def _layout_change(self, outputs: list[tuple[str, int, float, int, int, int, int]]) -> None:
         self._update_idle()
         self.layout = [PyWMOutput(n, i, s, w, h, (px, py)) for n, i, s, w, h, px, py in outputs]
+
+        """
+        Output keys have changed
+        """
+        for w in self._widgets.values():
+            w._down_sent = None
         logger.debug("PyWM layout change:")
         for o in self.layout:
             logger.debug("  %s", str(o))
@@ -339,8 +391,7 @@ class PyWM(Generic[ViewT], DamageTracked):
         self.on_layout_change()
 
 
-    @callback
-    def _update_view(self, handle: int, *args): # type: ignore
+    def _update_view_state(self, handle: int, *args): # type: ignore
         try:
             v = self._views[handle]
             try:
@@ -356,6 +407,10 @@ class PyWM(Generic[ViewT], DamageTracked):
             view._update(*args)
             return view.init().get(self, None, True, None, None, None, None, None)
 
+    @callback
+    def _update_view(self, handle: int, *args): # type: ignore
+        return self._update_view_state(handle, *args)
+
     @callback
     def _update_widget(self, handle: int, *args): # type: ignore
         try:
@@ -364,6 +419,53 @@ class PyWM(Generic[ViewT], DamageTracked):
         except Exception:
             return None
 
+    @callback
+    def _update_all(self, views: list[tuple[Any, ...]]) -> tuple[bytes, bytes, list[tuple[int, Any, Any]]]:
+        """
+        Batched version of _update_view and _update_widget - views are updated first, as widgets might depend on them
+
+        views only contains views with upstream changes, all others are only updated if needed. Likewise
+        only changed widgets are passed back
+        """
+        updates = [(args[0], self._update_view_state(*args)) for args in views]
+        updated = set(args[0] for args in views)
+        updates += [(h, self._update_view_state(h, *([None] * 8))) for h, v in list(self._views.items()) if h not in updated and v._needs_update()]
+
+        view_buf = bytearray(_PACKED_VIEW.size * len(updates))
+        for i, (handle, res) in enumerate(updates):
+            if res is None:
+                _PACKED_VIEW.pack_into(view_buf, i * _PACKED_VIEW.size, handle, 0, *([0] * 26))
+                continue
+
+            box, mask, opacity, corner_radius, z_index, accepts_input, lock_enabled, floating, size, \
+                focus, fullscreen, maximized, resizing, close, fixed_output, workspace = res
+            _PACKED_VIEW.pack_into(view_buf, i * _PACKED_VIEW.size, handle, 1,
+                                   *box, *mask, opacity, corner_radius, z_index,
+                                   accepts_input, lock_enabled, floating, *size,
+                                   focus, fullscreen, maximized, resizing, close, fixed_output,
+                                   *workspace)
+
+        widget_updates = []
+        for handle, widget in list(self._widgets.items()):
+            try:
+                wres = widget._update()
+            except Exception:
+                logger.exception("widget._update failed")
+                continue
+            if wres is not None:
+                widget_updates += [(handle, wres)]
+
+        widget_buf = bytearray(_PACKED_WIDGET.size * len(widget_updates))
+        payloads: list[tuple[int, Any, Any]] = []
+        for i, (handle, wres) in enumerate(widget_updates):
+            lock_enabled, box, mask, output, opacity, corner_radius, z_index, workspace, pixels, primitive = wres
+            _PACKED_WIDGET.pack_into(widget_buf, i * _PACKED_WIDGET.size, handle, 1,
+                                     lock_enabled, *box, *mask, output, opacity, corner_radius, z_index, *workspace)
+            if pixels is not None or primitive is not None:
+                payloads += [(handle, pixels, primitive)]
+
+        return bytes(view_buf), bytes(widget_buf), payloads
+
 
     @callback
     def _destroy_view(self, handle: int) -> None:
@@ -494,6 +596,10 @@ class PyWM(Generic[ViewT], DamageTracked):
     def is_locked(self) -> bool:
         return self._down_state.lock_perc != 0.0
 
+    def frame_timings(self) -> dict[int, list[PyWMFrameTiming]]:
+        # Recent frames per output key, oldest first - requires config frame_timing
+        return {key: [PyWMFrameTiming(*r) for r in _PACKED_FRAME_TIMING.iter_unpack(packed)] for key, packed in frame_timings()}
+
     def _get_round_scale(self, x: float, y: float, w: float, h: float) -> float:
         scale: Optional[float] = None
         for o in self.layout:
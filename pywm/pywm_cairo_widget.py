@@ -1,11 +1,11 @@
 from __future__ import annotations
-from typing import TYPE_CHECKING, Any
+from typing import TYPE_CHECKING, Any, Optional
 
 import cairo
-import numpy as np
 from abc import abstractmethod
 
 from .pywm_widget import PyWMWidget
+from ._pywm import PixelBuffer
 
 if TYPE_CHECKING:
     from .pywm import PyWM, PyWMOutput, ViewT
@@ -18,17 +18,37 @@ class PyWMCairoWidget(PyWMWidget):
         self.width = max(1, width)
         self.height = max(1, height)
 
-    def render(self) -> None:
-        surface = cairo.ImageSurface(cairo.FORMAT_ARGB32,
-                                     self.width, self.height)
-        self._render(surface)
-        buf = surface.get_data()
-        data: np.ndarray = np.ndarray(shape=(self.width, self.height, 4),
-                                      dtype=np.uint8,
-                                      buffer=buf)
-        data = data.reshape((self.width * self.height * 4), order='C')
-        self.set_pixels(4*self.width,
-                        self.width, self.height, data.tobytes())
+        """
+        Cairo renders directly into the shared buffer passed to the compositor
+        """
+        self._buffer: PixelBuffer
+        self._surface: cairo.ImageSurface
+        self._allocate()
+
+    def _allocate(self) -> None:
+        self._buffer = PixelBuffer(max(1, self.width), max(1, self.height))
+        self._surface = cairo.ImageSurface.create_for_data(memoryview(self._buffer), cairo.FORMAT_ARGB32,
+                                                           self._buffer.width, self._buffer.height, self._buffer.stride)
+
+    def render(self, region: Optional[tuple[int, int, int, int]]=None) -> None:
+        """
+        region (x, y, width, height) - if given, only this part of the rendered image is expected to change
+        """
+        if (self._buffer.width, self._buffer.height) != (max(1, self.width), max(1, self.height)):
+            """
+            width / height changed - the whole image is new
+            """
+            self._surface.finish()
+            self._allocate()
+            region = None
+
+        ctx = cairo.Context(self._surface)
+        ctx.set_operator(cairo.OPERATOR_CLEAR)
+        ctx.paint()
+
+        self._render(self._surface)
+        self._surface.flush()
+        self.set_buffer(self._buffer, region)
 
     @abstractmethod
     def _render(self, surface: cairo.ImageSurface) -> None:
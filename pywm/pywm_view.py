@@ -187,15 +187,31 @@ class PyWMView(Generic[PyWMT], DamageTracked):
         return self._handle == other._handle
 
 
+    def _needs_update(self) -> bool:
+        """
+        Whether _update has to be called even without upstream changes
+        """
+        return self._damaged or \
+            self._down_force_size or \
+            self._down_action_focus is not None or \
+            self._down_action_fullscreen is not None or \
+            self._down_action_maximized is not None or \
+            self._down_action_resizing is not None or \
+            self._down_action_close is not None
+
     def _update(self,
                 general: Optional[tuple[int, bool, int, str, str, str]],
-                width: int, height: int,
-                is_mapped: bool, is_floating: bool, is_focused: bool, is_fullscreen: bool, is_maximized: bool, is_resizing: bool, is_inhibiting_idle: bool,
-                size_constraints: list[int],
-                offset_x: int, offset_y: int,
-                shows_csd: bool,
-                fixed_output_key: int,
+                size: Optional[tuple[int, int]],
+                is_mapped: Optional[bool],
+                state: Optional[tuple[bool, bool, bool, bool, bool, bool]],
+                size_constraints: Optional[list[int]],
+                offset: Optional[tuple[int, int]],
+                shows_csd: Optional[bool],
+                fixed_output_key: Optional[int],
                 ) -> tuple[tuple[float, float, float, float], tuple[float, float, float, float], float, float, float, bool, bool, int, tuple[int, int], int, int, int, int, int, int, tuple[float, float, float, float]]:
+        """
+        Every part of the upstream state is None if unchanged since the last call
+        """
         if general is not None:
             if self.parent is None:
                 try:
@@ -209,16 +225,41 @@ class PyWMView(Generic[PyWMT], DamageTracked):
             self.role = general[4]
             self.title = general[5]
 
-        up_state = PyWMViewUpstreamState(
-            is_mapped,
-            is_floating,
-            size_constraints,
-            offset_x, offset_y,
-            width, height,
-            is_focused, is_fullscreen, is_maximized, is_resizing, is_inhibiting_idle,
-            shows_csd,
-            self.wm.get_output_by_key(fixed_output_key) if fixed_output_key >= 0 else None
-        )
+        up_state = self.up_state
+        if up_state is None or size is not None or is_mapped is not None or state is not None or \
+                size_constraints is not None or offset is not None or shows_csd is not None or fixed_output_key is not None:
+            last = self.up_state
+            if size is None:
+                size = last.size if last is not None else (0, 0)
+            if is_mapped is None:
+                is_mapped = last.is_mapped if last is not None else False
+            if state is None:
+                state = (last.is_floating, last.is_focused, last.is_fullscreen, last.is_maximized, last.is_resizing, last.is_inhibiting_idle) \
+                    if last is not None else (False, False, False, False, False, False)
+            if size_constraints is None:
+                size_constraints = last.size_constraints if last is not None else []
+            if offset is None:
+                offset = last.offset if last is not None else (0, 0)
+            if shows_csd is None:
+                shows_csd = last.shows_csd if last is not None else False
+
+            if fixed_output_key is not None:
+                fixed_output = self.wm.get_output_by_key(fixed_output_key) if fixed_output_key >= 0 else None
+            else:
+                fixed_output = last.fixed_output if last is not None else None
+
+            is_floating, is_focused, is_fullscreen, is_maximized, is_resizing, is_inhibiting_idle = state
+            up_state = PyWMViewUpstreamState(
+                is_mapped,
+                is_floating,
+                size_constraints,
+                offset[0], offset[1],
+                size[0], size[1],
+                is_focused, is_fullscreen, is_maximized, is_resizing, is_inhibiting_idle,
+                shows_csd,
+                fixed_output
+            )
+
         last_up_state = self.up_state
         down_state: Optional[PyWMViewDownstreamState] = self._down_state
 
@@ -1,9 +1,10 @@
 from __future__ import annotations
-from typing import TYPE_CHECKING, TypeVar, Optional, Generic
+from typing import TYPE_CHECKING, TypeVar, Optional, Generic, Union
 
 from abc import abstractmethod
 
 from .damage_tracked import DamageTracked
+from ._pywm import PixelBuffer
 
 if TYPE_CHECKING:
     from .pywm import PyWM, PyWMOutput, ViewT
@@ -11,6 +12,11 @@ if TYPE_CHECKING:
 else:
     PyWMT = TypeVar('PyWMT')
 
+"""
+(stride, width, height, data) or PixelBuffer, optionally together with the changed region (x, y, width, height)
+"""
+Pixels = Union[tuple[int, int, int, bytes], PixelBuffer, tuple[Union[tuple[int, int, int, bytes], PixelBuffer], tuple[int, int, int, int]]]
+
 
 class PyWMWidgetDownstreamState:
     def __init__(self, z_index: float=0, box: tuple[float, float, float, float]=(0, 0, 0, 0), mask: tuple[float, float, float, float]=(-1, -1, -1, -1), opacity: float=1., corner_radius: float=0, lock_enabled: bool=True, workspace: Optional[tuple[float, float, float, float]]=None, primitive: Optional[str]=None) -> None:
@@ -26,7 +32,7 @@ class PyWMWidgetDownstreamState:
     def copy(self) -> PyWMWidgetDownstreamState:
         return PyWMWidgetDownstreamState(self.z_index, self.box, self.mask, self.opacity, self.corner_radius, self.lock_enabled, self.workspace)
 
-    def get(self, root: PyWM[ViewT], output: Optional[PyWMOutput], pixels: Optional[tuple[int, int, int, bytes]], primitive: Optional[tuple[str, list[int], list[float]]]) -> tuple[bool, tuple[float, float, float, float], tuple[float, float, float, float], int, float, float, float, tuple[float, float, float, float], Optional[tuple[int, int, int, bytes]], Optional[tuple[str, list[int], list[float]]]]:
+    def get(self, root: PyWM[ViewT], output: Optional[PyWMOutput], pixels: Optional[Pixels], primitive: Optional[tuple[str, list[int], list[float]]]) -> tuple[bool, tuple[float, float, float, float], tuple[float, float, float, float], int, float, float, float, tuple[float, float, float, float], Optional[Pixels], Optional[tuple[str, list[int], list[float]]]]:
         return (
             self.lock_enabled,
             root.round(*self.box, wh_logical=False),
@@ -51,28 +57,73 @@ class PyWMWidget(Generic[PyWMT], DamageTracked):
 
         self._down_state = PyWMWidgetDownstreamState(0, (0, 0, 0, 0))
 
+        self._pending_pixels: Optional[Union[tuple[int, int, int, bytes], PixelBuffer]] = None
+
         """
-        (stride, width, height, data)
+        Bounding box (x, y, width, height) of the pixels changed since the last update, None if all
         """
-        self._pending_pixels: Optional[tuple[int, int, int, bytes]] = None
+        self._pending_pixels_region: Optional[tuple[int, int, int, int]] = None
 
         self._pending_primitive: Optional[tuple[str, list[int], list[float]]] = None
 
-    def _update(self) -> tuple[bool, tuple[float, float, float, float], tuple[float, float, float, float], int, float, float, float, tuple[float, float, float, float], Optional[tuple[int, int, int, bytes]], Optional[tuple[str, list[int], list[float]]]]:
-        if self.is_damaged():
+        """
+        Last state passed on (without pixels and primitive), None to force passing it on again
+        """
+        self._down_sent: Optional[tuple[bool, tuple[float, float, float, float], tuple[float, float, float, float], int, float, float, float, tuple[float, float, float, float]]] = None
+
+    def _update(self) -> Optional[tuple[bool, tuple[float, float, float, float], tuple[float, float, float, float], int, float, float, float, tuple[float, float, float, float], Optional[Pixels], Optional[tuple[str, list[int], list[float]]]]]:
+        """
+        None if nothing changed since the last call
+        """
+        damaged = self.is_damaged()
+        if not damaged and self._down_sent is not None and self._pending_pixels is None and self._pending_primitive is None:
+            return None
+
+        if damaged:
             self._down_state = self.process()
-        pixels = self._pending_pixels
+        pixels: Optional[Pixels] = self._pending_pixels
+        if pixels is not None and self._pending_pixels_region is not None:
+            pixels = (self._pending_pixels, self._pending_pixels_region)
         primitive = self._pending_primitive
         self._pending_pixels = None
+        self._pending_pixels_region = None
         self._pending_primitive = None
-        return self._down_state.get(self.wm, self.output, pixels, primitive)
+        res = self._down_state.get(self.wm, self.output, pixels, primitive)
+
+        if pixels is None and primitive is None and res[:8] == self._down_sent:
+            return None
+        self._down_sent = res[:8]
+        return res
 
     def destroy(self) -> None:
         self.wm.widget_destroy(self)
 
-    def set_pixels(self, stride: int, width: int, height: int, data: bytes) -> None:
+    def _set_pixels_region(self, region: Optional[tuple[int, int, int, int]]) -> None:
+        if region is None:
+            self._pending_pixels_region = None
+        elif self._pending_pixels is None:
+            self._pending_pixels_region = region
+        elif self._pending_pixels_region is not None:
+            x, y, w, h = self._pending_pixels_region
+            x1, y1 = min(x, region[0]), min(y, region[1])
+            x2, y2 = max(x + w, region[0] + region[2]), max(y + h, region[1] + region[3])
+            self._pending_pixels_region = (x1, y1, x2 - x1, y2 - y1)
+
+    def set_pixels(self, stride: int, width: int, height: int, data: bytes, region: Optional[tuple[int, int, int, int]]=None) -> None:
+        """
+        data is always the full image; if given, only region (x, y, width, height) has changed
+        """
+        self._set_pixels_region(region)
         self._pending_pixels = (stride, width, height, data)
 
+    def set_buffer(self, buffer: PixelBuffer, region: Optional[tuple[int, int, int, int]]=None) -> None:
+        """
+        Pass buffer without copying it on the python side - its contents are read on the next update.
+        If given, only region (x, y, width, height) has changed
+        """
+        self._set_pixels_region(region)
+        self._pending_pixels = buffer
+
     def set_primitive(self, name: str, params_int: list[int], params_float: list[float]) -> None:
         self._pending_primitive = name, params_int, params_float
 
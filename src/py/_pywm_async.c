@@ -0,0 +1,440 @@
+#define _GNU_SOURCE
+#include <Python.h>
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <wayland-server.h>
+
+#include "wm/wm.h"
+#include "wm/wm_server.h"
+#include "wm/wm_config.h"
+#include "wm/wm_util.h"
+#include "py/_pywm_async.h"
+#include "py/_pywm_callbacks.h"
+#include "py/_pywm_view.h"
+#include "py/_pywm_widget.h"
+
+struct _pywm_async_upstream {
+    struct _pywm_view_changes* views;
+    int n_views;
+    int size_views;
+};
+
+struct _pywm_async_downstream {
+    /* Result of update */
+    bool update_valid;
+    int update_cursor;
+    int update_cursor_x;
+    int update_cursor_y;
+    double lock_perc;
+    int terminate;
+    char open_virtual_output[WM_CONFIG_STRLEN];
+    char close_virtual_output[WM_CONFIG_STRLEN];
+    PyObject* config;
+
+    /* Result of query_destroy_widget / query_new_widget */
+    long destroy_widget;
+    long new_widget;
+    int new_widget_type;
+
+    /* Result of update_all - dropped as a whole unless all of it could be parsed */
+    bool update_all_valid;
+    char* views;
+    long n_views;
+    long size_views;
+
+    char* widgets;
+    long n_widgets;
+    long size_widgets;
+
+    struct _pywm_widget_payload* payloads;
+    int n_payloads;
+    int size_payloads;
+
+    /* Views whose upstream changes have been passed to update_all */
+    long* taken_views;
+    int n_taken_views;
+    int size_taken_views;
+};
+
+static struct {
+    bool enabled;
+    void (*apply_config)(PyObject* config);
+
+    pthread_t thread;
+    atomic_bool running;
+
+    /* Posted by the compositor to request an update */
+    sem_t kick;
+
+    /* Written by the python thread once downstream is ready */
+    int wake_fd;
+    struct wl_event_source* wake_source;
+
+    /* Set by the producing side, cleared by the consuming side once done */
+    atomic_bool upstream_ready;
+    atomic_bool downstream_ready;
+
+    struct _pywm_async_upstream upstream;
+    struct _pywm_async_downstream downstream;
+} async = { 0 };
+
+static void copy_buffer(char** dest, long* n, long* size, const void* src, long len){
+    if(len > *size){
+        *size = len;
+        *dest = realloc(*dest, *size);
+        assert(*dest);
+    }
+    if(len > 0){
+        memcpy(*dest, src, len);
+    }
+    *n = len;
+}
+
+/*
+ * Python thread, GIL held
+ */
+static void report_error(const char* msg){
+    wlr_log(WLR_ERROR, "Python error: %s", msg);
+    if(PyErr_Occurred()){
+        PyErr_Print();
+    }
+}
+
+static void produce_update(struct _pywm_async_downstream* down){
+    PyObject* args = Py_BuildValue("()");
+    PyObject* res = PyObject_Call(_pywm_callbacks_get_all()->update, args, NULL);
+    Py_XDECREF(args);
+
+    const char* open_virtual_output, *close_virtual_output;
+    PyObject* config;
+
+    if(!res){
+        report_error("update failed");
+    }else if(!PyArg_ParseTuple(res,
+                "iiidsspO",
+                &down->update_cursor,
+                &down->update_cursor_x,
+                &down->update_cursor_y,
+                &down->lock_perc,
+                &open_virtual_output,
+                &close_virtual_output,
+                &down->terminate,
+                &config)){
+        report_error("Cannot parse update return");
+    }else{
+        down->update_valid = true;
+        strncpy(down->open_virtual_output, open_virtual_output, WM_CONFIG_STRLEN-1);
+        strncpy(down->close_virtual_output, close_virtual_output, WM_CONFIG_STRLEN-1);
+        down->open_virtual_output[WM_CONFIG_STRLEN-1] = 0;
+        down->close_virtual_output[WM_CONFIG_STRLEN-1] = 0;
+
+        if(config && config != Py_None){
+            Py_INCREF(config);
+            down->config = config;
+        }
+    }
+    Py_XDECREF(res);
+}
+
+static void release_payloads(struct _pywm_async_downstream* down){
+    for(int i=0; i<down->n_payloads; i++){
+        _pywm_widget_payload_release(&down->payloads[i]);
+    }
+    down->n_payloads = 0;
+}
+
+static bool produce_payloads(struct _pywm_async_downstream* down, PyObject* payloads){
+    if(payloads == Py_None) return true;
+    if(!PyList_Check(payloads)){
+        PyErr_SetString(PyExc_TypeError, "Expected list of payloads");
+        return false;
+    }
+
+    /* Pixels and primitives: list of (handle, pixels, primitive) */
+    for(int i=0; i<PyList_Size(payloads); i++){
+        long handle;
+        PyObject* pixels;
+        PyObject* primitive;
+        if(!PyArg_ParseTuple(PyList_GetItem(payloads, i), "lOO", &handle, &pixels, &primitive)){
+            return false;
+        }
+
+        if(down->n_payloads == down->size_payloads){
+            down->size_payloads = down->size_payloads ? 2 * down->size_payloads : 8;
+            down->payloads = realloc(down->payloads, down->size_payloads * sizeof(struct _pywm_widget_payload));
+            assert(down->payloads);
+        }
+
+        struct _pywm_widget_payload* payload = &down->payloads[down->n_payloads];
+        if(!_pywm_widget_payload_parse(payload, handle, pixels, primitive)){
+            return false;
+        }
+        down->n_payloads++;
+
+        if(!_pywm_widget_payload_snapshot(payload)){
+            return false;
+        }
+    }
+    return true;
+}
+
+static void produce_update_all(struct _pywm_async_downstream* down){
+    PyObject* list = PyList_New(0);
+    if(atomic_load(&async.upstream_ready)){
+        for(int i=0; i<async.upstream.n_views; i++){
+            PyObject* args = _pywm_view_changes_build_args(&async.upstream.views[i]);
+            PyList_Append(list, args);
+            Py_DECREF(args);
+
+            if(down->n_taken_views == down->size_taken_views){
+                down->size_taken_views = down->size_taken_views ? 2 * down->size_taken_views : 8;
+                down->taken_views = realloc(down->taken_views, down->size_taken_views * sizeof(long));
+                assert(down->taken_views);
+            }
+            down->taken_views[down->n_taken_views++] = async.upstream.views[i].handle;
+
+            _pywm_view_changes_finish(&async.upstream.views[i]);
+        }
+        async.upstream.n_views = 0;
+        atomic_store(&async.upstream_ready, false);
+    }
+
+    PyObject* args = Py_BuildValue("(N)", list);
+    PyObject* res = PyObject_Call(_pywm_callbacks_get_all()->update_all, args, NULL);
+    Py_XDECREF(args);
+
+    /* The python side returns None if update_all raised */
+    if(!res || res == Py_None){
+        report_error("update_all failed");
+        Py_XDECREF(res);
+        return;
+    }
+
+    Py_buffer views;
+    Py_buffer widgets;
+    PyObject* payloads;
+    if(!PyArg_ParseTuple(res, "y*y*O", &views, &widgets, &payloads)){
+        report_error("Cannot parse update_all return");
+        Py_DECREF(res);
+        return;
+    }
+
+    if(produce_payloads(down, payloads)){
+        copy_buffer(&down->views, &down->n_views, &down->size_views, views.buf, views.len);
+        copy_buffer(&down->widgets, &down->n_widgets, &down->size_widgets, widgets.buf, widgets.len);
+        down->update_all_valid = true;
+    }else{
+        report_error("Cannot parse update_all payload");
+        release_payloads(down);
+    }
+
+    PyBuffer_Release(&views);
+    PyBuffer_Release(&widgets);
+    Py_DECREF(res);
+}
+
+static void release_downstream(struct _pywm_async_downstream* down){
+    release_payloads(down);
+
+    Py_XDECREF(down->config);
+    down->config = NULL;
+}
+
+static void produce(struct _pywm_async_downstream* down){
+    /* The compositor is done with the last result */
+    release_downstream(down);
+    down->update_valid = false;
+    down->update_all_valid = false;
+    down->n_views = 0;
+    down->n_widgets = 0;
+    down->n_taken_views = 0;
+
+    produce_update(down);
+
+    _pywm_widgets_query_structure(&down->destroy_widget, &down->new_widget, &down->new_widget_type);
+    if(PyErr_Occurred()){
+        report_error("Cannot query widget structure");
+    }
+
+    produce_update_all(down);
+}
+
+static void* thread_main(void* data){
+    while(true){
+        while(sem_wait(&async.kick) < 0 && errno == EINTR);
+
+        /* Coalesce requests */
+        while(sem_trywait(&async.kick) == 0);
+
+        if(!atomic_load(&async.running)) break;
+
+        /* Wait for the compositor to apply the last result */
+        if(atomic_load(&async.downstream_ready)) continue;
+
+        PyGILState_STATE gil = PyGILState_Ensure();
+        TIMER_START(callback_update_async);
+        produce(&async.downstream);
+        TIMER_STOP(callback_update_async);
+        TIMER_PRINT(callback_update_async);
+        PyGILState_Release(gil);
+
+        atomic_store(&async.downstream_ready, true);
+
+        uint64_t one = 1;
+        if(write(async.wake_fd, &one, sizeof(one)) < 0){
+            wlr_log_errno(WLR_ERROR, "Could not wake compositor");
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Compositor thread
+ */
+static void consume(){
+    if(!atomic_load(&async.downstream_ready)) return;
+
+    struct _pywm_async_downstream* down = &async.downstream;
+
+    if(down->update_valid){
+        if(down->update_cursor >= 0){
+            wm_update_cursor(down->update_cursor, down->update_cursor_x, down->update_cursor_y);
+        }
+        wm_set_locked(down->lock_perc);
+        if(down->terminate){
+            wm_terminate();
+        }
+
+        if(strlen(down->open_virtual_output) > 0){
+            wm_open_virtual_output(down->open_virtual_output);
+        }
+        if(strlen(down->close_virtual_output) > 0){
+            wm_close_virtual_output(down->close_virtual_output);
+        }
+    }
+
+    /* Reconfiguration is rare, so accept waiting for the GIL */
+    if(down->config){
+        PyGILState_STATE gil = PyGILState_Ensure();
+        (*async.apply_config)(down->config);
+        Py_DECREF(down->config);
+        down->config = NULL;
+        PyGILState_Release(gil);
+    }
+
+    _pywm_widgets_apply_structure(down->destroy_widget, down->new_widget, down->new_widget_type);
+
+    if(down->update_all_valid){
+        if(!_pywm_views_update_apply(down->views, down->n_views)){
+            wlr_log(WLR_ERROR, "Cannot parse packed update_view return");
+        }
+        if(!_pywm_widgets_update_apply_states(down->widgets, down->n_widgets)){
+            wlr_log(WLR_ERROR, "Cannot parse packed update_widget return");
+        }
+        for(int i=0; i<down->n_payloads; i++){
+            _pywm_widgets_apply_payload(&down->payloads[i]);
+        }
+    }else{
+        /* Python has not seen these changes - resend the full state */
+        for(int i=0; i<down->n_taken_views; i++){
+            _pywm_views_invalidate_upstream(down->taken_views[i]);
+        }
+    }
+
+    atomic_store(&async.downstream_ready, false);
+}
+
+static int handle_wake(int fd, uint32_t mask, void* data){
+    uint64_t count;
+    if(read(fd, &count, sizeof(count)) < 0 && errno != EAGAIN){
+        wlr_log_errno(WLR_ERROR, "Could not read wake event");
+    }
+
+    TIMER_START(callback_update_async_apply);
+    consume();
+    TIMER_STOP(callback_update_async_apply);
+    TIMER_PRINT(callback_update_async_apply);
+    return 0;
+}
+
+void _pywm_async_update(){
+    consume();
+
+    if(!atomic_load(&async.upstream_ready)){
+        async.upstream.n_views = _pywm_views_collect_changes(&async.upstream.views, &async.upstream.size_views);
+        atomic_store(&async.upstream_ready, true);
+    }
+
+    sem_post(&async.kick);
+}
+
+void _pywm_async_start(void (*apply_config)(PyObject* config)){
+    async.apply_config = apply_config;
+
+    async.wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if(async.wake_fd < 0){
+        wlr_log_errno(WLR_ERROR, "Could not create eventfd - falling back to synchronous update");
+        return;
+    }
+
+    sem_init(&async.kick, 0, 0);
+    atomic_store(&async.upstream_ready, false);
+    atomic_store(&async.downstream_ready, false);
+    atomic_store(&async.running, true);
+
+    async.wake_source = wl_event_loop_add_fd(get_wm()->server->wl_event_loop,
+            async.wake_fd, WL_EVENT_READABLE, handle_wake, NULL);
+
+    if(pthread_create(&async.thread, NULL, thread_main, NULL)){
+        wlr_log(WLR_ERROR, "Could not start update thread - falling back to synchronous update");
+        wl_event_source_remove(async.wake_source);
+        close(async.wake_fd);
+        sem_destroy(&async.kick);
+        return;
+    }
+
+    wlr_log(WLR_INFO, "Running python update on its own thread");
+    async.enabled = true;
+}
+
+void _pywm_async_stop(){
+    if(!async.enabled) return;
+
+    atomic_store(&async.running, false);
+    sem_post(&async.kick);
+    pthread_join(async.thread, NULL);
+
+    wl_event_source_remove(async.wake_source);
+    close(async.wake_fd);
+    sem_destroy(&async.kick);
+
+    PyGILState_STATE gil = PyGILState_Ensure();
+    release_downstream(&async.downstream);
+    PyGILState_Release(gil);
+
+    for(int i=0; i<async.upstream.n_views; i++){
+        _pywm_view_changes_finish(&async.upstream.views[i]);
+    }
+    free(async.upstream.views);
+    free(async.downstream.views);
+    free(async.downstream.widgets);
+    free(async.downstream.payloads);
+    free(async.downstream.taken_views);
+    async.upstream = (struct _pywm_async_upstream){ 0 };
+    async.downstream = (struct _pywm_async_downstream){ 0 };
+
+    async.enabled = false;
+}
+
+bool _pywm_async_enabled(){
+    return async.enabled;
+}
@@ -0,0 +1,113 @@
+#define _GNU_SOURCE
+#include <Python.h>
+#include <structmember.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "py/_pywm_buffer.h"
+
+static PyObject* _pywm_buffer_new(PyTypeObject* type, PyObject* args, PyObject* kwargs){
+    int width, height;
+    if(!PyArg_ParseTuple(args, "ii", &width, &height)){
+        return NULL;
+    }
+
+    if(width <= 0 || height <= 0){
+        PyErr_SetString(PyExc_ValueError, "Invalid size");
+        return NULL;
+    }
+
+    struct _pywm_buffer* self = (struct _pywm_buffer*)type->tp_alloc(type, 0);
+    if(!self) return NULL;
+
+    self->width = width;
+    self->height = height;
+    self->stride = 4 * width;
+    self->size = (size_t)self->stride * height;
+    self->data = NULL;
+    self->snapshot = NULL;
+    self->snapshot_valid = false;
+
+    self->fd = memfd_create("pywm-pixels", MFD_CLOEXEC);
+    if(self->fd < 0 || ftruncate(self->fd, self->size) < 0){
+        PyErr_SetFromErrno(PyExc_OSError);
+        Py_DECREF(self);
+        return NULL;
+    }
+
+    self->data = mmap(NULL, self->size, PROT_READ | PROT_WRITE, MAP_SHARED, self->fd, 0);
+    if(self->data == MAP_FAILED){
+        self->data = NULL;
+        PyErr_SetFromErrno(PyExc_OSError);
+        Py_DECREF(self);
+        return NULL;
+    }
+
+    return (PyObject*)self;
+}
+
+static void _pywm_buffer_dealloc(struct _pywm_buffer* self){
+    if(self->data) munmap(self->data, self->size);
+    if(self->fd >= 0) close(self->fd);
+    free(self->snapshot);
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+const void* _pywm_buffer_snapshot(struct _pywm_buffer* buffer, int x, int y, int width, int height){
+    if(!buffer->snapshot){
+        buffer->snapshot = malloc(buffer->size);
+        if(!buffer->snapshot) return NULL;
+    }
+
+    if(!buffer->snapshot_valid){
+        x = 0;
+        y = 0;
+        width = buffer->width;
+        height = buffer->height;
+    }
+
+    int x0 = x < 0 ? 0 : x;
+    int y0 = y < 0 ? 0 : y;
+    int x1 = x + width > buffer->width ? buffer->width : x + width;
+    int y1 = y + height > buffer->height ? buffer->height : y + height;
+
+    for(int row=y0; row<y1 && x0<x1; row++){
+        size_t offset = (size_t)row * buffer->stride + 4 * x0;
+        memcpy((char*)buffer->snapshot + offset, (char*)buffer->data + offset, 4 * (x1 - x0));
+    }
+
+    buffer->snapshot_valid = true;
+    return buffer->snapshot;
+}
+
+static int _pywm_buffer_getbuffer(struct _pywm_buffer* self, Py_buffer* view, int flags){
+    return PyBuffer_FillInfo(view, (PyObject*)self, self->data, self->size, 0, flags);
+}
+
+static PyBufferProcs _pywm_buffer_as_buffer = {
+    .bf_getbuffer = (getbufferproc)_pywm_buffer_getbuffer,
+    .bf_releasebuffer = NULL,
+};
+
+static PyMemberDef _pywm_buffer_members[] = {
+    { "width",  T_INT, offsetof(struct _pywm_buffer, width),  READONLY, "Width in pixels" },
+    { "height", T_INT, offsetof(struct _pywm_buffer, height), READONLY, "Height in pixels" },
+    { "stride", T_INT, offsetof(struct _pywm_buffer, stride), READONLY, "Bytes per row" },
+
+    { NULL }
+};
+
+PyTypeObject _pywm_buffer_type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "_pywm.PixelBuffer",
+    .tp_doc = "Shared memory ARGB8888 pixel buffer to be passed to widgets",
+    .tp_basicsize = sizeof(struct _pywm_buffer),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_new = _pywm_buffer_new,
+    .tp_dealloc = (destructor)_pywm_buffer_dealloc,
+    .tp_as_buffer = &_pywm_buffer_as_buffer,
+    .tp_members = _pywm_buffer_members,
+};
@@ -313,6 +313,8 @@ PyObject** _pywm_callbacks_get(const char* name){
         return &callbacks.query_destroy_widget;
     }else if(!strcmp(name, "update")){
         return &callbacks.update;
+    }else if(!strcmp(name, "update_all")){
+        return &callbacks.update_all;
     }else if(!strcmp(name, "view_event")){
         return &callbacks.view_event;
     }
@@ -1,6 +1,7 @@
 #include <Python.h>
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 #include "wm/wm.h"
@@ -13,6 +14,7 @@
 
 #include "py/_pywm_view.h"
 #include "py/_pywm_callbacks.h"
+#include "py/_pywm_packed.h"
 
 static struct _pywm_views views = { 0 };
 
@@ -24,182 +26,359 @@ void _pywm_view_init(struct _pywm_view* _view, struct wm_view* view){
     _view->view = view;
     _view->next_view = NULL;
 
-    _view->update_cnt = 0;
+    _view->upstream.valid = false;
+    _view->upstream.size_constraints = NULL;
+    _view->upstream.n_size_constraints = 0;
 }
 
 
-void _pywm_view_update(struct _pywm_view* view){
-
-    /* General info */
-    PyObject* args_general = Py_None;
-    if(++view->update_cnt % 20 == 1){
-        long parent_handle = 0;
-        struct wm_view* parent = wm_view_get_parent(view->view);
-        if(parent){
-            parent_handle = _pywm_views_get_handle(parent);
-        }
+struct _pywm_view_downstream {
+    double x, y, w, h;
+    double mask_x, mask_y, mask_w, mask_h;
+    double opacity;
+    double corner_radius;
+    double z_index;
+    int accepts_input;
+    int lock_enabled;
+    int floating;
+    int width_pending, height_pending;
+    int focus_pending;
+    int fullscreen_pending;
+    int maximized_pending;
+    int resizing_pending;
+    int close_pending;
+    int fixed_output_key;
+    double workspace_x, workspace_y, workspace_w, workspace_h;
+};
+
+static char* _pywm_strdup(const char* str){
+    return str ? strdup(str) : NULL;
+}
 
-        pid_t pid;
-        uid_t uid;
-        gid_t gid;
-        wm_view_get_credentials(view->view, &pid, &uid, &gid);
+static void _pywm_view_collect_general(struct _pywm_view* view, struct _pywm_view_changes* changes){
+    changes->parent_handle = 0;
+    struct wm_view* parent = wm_view_get_parent(view->view);
+    if(parent){
+        changes->parent_handle = _pywm_views_get_handle(parent);
+    }
 
-        const char* title;
-        const char* app_id;
-        const char* role;
-        wm_view_get_info(view->view, &title, &app_id, &role);
+    pid_t pid;
+    uid_t uid;
+    gid_t gid;
+    wm_view_get_credentials(view->view, &pid, &uid, &gid);
+    changes->pid = pid;
 
-        /* If title is not yet there - resend */
-        if(!title || !strcmp(title, "")){
-            view->update_cnt--;
-        }
+    const char* title;
+    const char* app_id;
+    const char* role;
+    wm_view_get_info(view->view, &title, &app_id, &role);
+    changes->title = _pywm_strdup(title);
+    changes->app_id = _pywm_strdup(app_id);
+    changes->role = _pywm_strdup(role);
 
 #ifdef WM_HAS_XWAYLAND
-        bool xwayland = wm_view_is_xwayland(view->view);
+    changes->xwayland = wm_view_is_xwayland(view->view);
 #else
-        bool xwayland = false;
+    changes->xwayland = false;
 #endif
+}
 
-        args_general = Py_BuildValue(
-                "(lOisss)",
-                parent_handle,
-                xwayland ? Py_True : Py_False,
-                pid,
-                app_id,
-                role,
-                title);
+bool _pywm_view_collect_changes(struct _pywm_view* view, struct _pywm_view_changes* changes){
+    struct wm_view* v = view->view;
+    unsigned int dirty = view->upstream.valid ? v->dirty : WM_VIEW_DIRTY_ALL;
+    v->dirty = 0;
+
+    changes->handle = view->handle;
+    changes->changed = 0;
+    changes->title = NULL;
+    changes->app_id = NULL;
+    changes->role = NULL;
+    changes->size_constraints = NULL;
+    changes->n_size_constraints = 0;
+
+    if(dirty & WM_VIEW_DIRTY_INFO){
+        _pywm_view_collect_general(view, changes);
+        changes->changed |= WM_VIEW_DIRTY_INFO;
+    }
+
+    if(dirty & WM_VIEW_DIRTY_SIZE){
+        int width, height;
+        wm_view_get_size(v, &width, &height);
+        if(!view->upstream.valid || width != view->upstream.width || height != view->upstream.height){
+            view->upstream.width = width;
+            view->upstream.height = height;
+            changes->width = width;
+            changes->height = height;
+            changes->changed |= WM_VIEW_DIRTY_SIZE;
+        }
     }
 
-    /* Current info */
-    int width, height;
-    wm_view_get_size(view->view, &width, &height);
+    if(dirty & WM_VIEW_DIRTY_MAPPED){
+        if(!view->upstream.valid || v->mapped != view->upstream.mapped){
+            view->upstream.mapped = v->mapped;
+            changes->mapped = v->mapped;
+            changes->changed |= WM_VIEW_DIRTY_MAPPED;
+        }
+    }
 
-    int is_mapped = view->view->mapped;
+    if(dirty & WM_VIEW_DIRTY_STATE){
+        bool floating = wm_view_is_floating(v);
+        bool focused = wm_view_is_focused(v);
+        bool fullscreen = wm_view_is_fullscreen(v);
+        bool maximized = wm_view_is_maximized(v);
+        bool resizing = wm_view_is_resizing(v);
+        bool inhibiting_idle = wm_view_is_inhibiting_idle(v);
+
+        if(!view->upstream.valid ||
+                floating != view->upstream.floating ||
+                focused != view->upstream.focused ||
+                fullscreen != view->upstream.fullscreen ||
+                maximized != view->upstream.maximized ||
+                resizing != view->upstream.resizing ||
+                inhibiting_idle != view->upstream.inhibiting_idle){
+            view->upstream.floating = changes->floating = floating;
+            view->upstream.focused = changes->focused = focused;
+            view->upstream.fullscreen = changes->fullscreen = fullscreen;
+            view->upstream.maximized = changes->maximized = maximized;
+            view->upstream.resizing = changes->resizing = resizing;
+            view->upstream.inhibiting_idle = changes->inhibiting_idle = inhibiting_idle;
+            changes->changed |= WM_VIEW_DIRTY_STATE;
+        }
+    }
 
-    int is_floating = wm_view_is_floating(view->view);
-    int is_focused = wm_view_is_focused(view->view);
-    int is_fullscreen = wm_view_is_fullscreen(view->view);
-    int is_maximized = wm_view_is_maximized(view->view);
-    int is_resizing = wm_view_is_resizing(view->view);
+    if(dirty & WM_VIEW_DIRTY_SIZE_CONSTRAINTS){
+        int* size_constraints;
+        int n_constraints;
+        wm_view_get_size_constraints(v, &size_constraints, &n_constraints);
+
+        if(!view->upstream.valid ||
+                n_constraints != view->upstream.n_size_constraints ||
+                (n_constraints > 0 && memcmp(size_constraints, view->upstream.size_constraints, n_constraints * sizeof(int)))){
+            if(n_constraints != view->upstream.n_size_constraints){
+                view->upstream.size_constraints = realloc(view->upstream.size_constraints, n_constraints * sizeof(int));
+                view->upstream.n_size_constraints = n_constraints;
+            }
+            memcpy(view->upstream.size_constraints, size_constraints, n_constraints * sizeof(int));
+
+            changes->size_constraints = malloc(n_constraints * sizeof(int));
+            memcpy(changes->size_constraints, size_constraints, n_constraints * sizeof(int));
+            changes->n_size_constraints = n_constraints;
+            changes->changed |= WM_VIEW_DIRTY_SIZE_CONSTRAINTS;
+        }
+    }
 
-    int is_inhibiting_idle = wm_view_is_inhibiting_idle(view->view);
+    if(dirty & WM_VIEW_DIRTY_OFFSET){
+        int offset_x, offset_y;
+        wm_view_get_offset(v, &offset_x, &offset_y);
+        if(!view->upstream.valid || offset_x != view->upstream.offset_x || offset_y != view->upstream.offset_y){
+            view->upstream.offset_x = offset_x;
+            view->upstream.offset_y = offset_y;
+            changes->offset_x = offset_x;
+            changes->offset_y = offset_y;
+            changes->changed |= WM_VIEW_DIRTY_OFFSET;
+        }
+    }
 
-    struct wm_output* fixed_output = wm_content_get_output(&view->view->super);
-    int fixed_output_key = fixed_output ? fixed_output->key : -1;
+    if(dirty & WM_VIEW_DIRTY_CSD){
+        bool shows_csd = wm_view_shows_csd(v);
+        if(!view->upstream.valid || shows_csd != view->upstream.shows_csd){
+            view->upstream.shows_csd = shows_csd;
+            changes->shows_csd = shows_csd;
+            changes->changed |= WM_VIEW_DIRTY_CSD;
+        }
+    }
 
-    int* size_constraints;
-    int n_constraints;
-    wm_view_get_size_constraints(view->view, &size_constraints, &n_constraints);
-    PyObject* args_size_constraints = PyList_New(n_constraints);
-    for (int i=0; i<n_constraints; i++){
-        PyObject* cur = Py_BuildValue("i", size_constraints[i]);
-        PyList_SetItem(args_size_constraints, i, cur);
+    if(dirty & WM_VIEW_DIRTY_OUTPUT){
+        struct wm_output* fixed_output = wm_content_get_output(&v->super);
+        int fixed_output_key = fixed_output ? fixed_output->key : -1;
+        if(!view->upstream.valid || fixed_output_key != view->upstream.fixed_output_key){
+            view->upstream.fixed_output_key = fixed_output_key;
+            changes->fixed_output_key = fixed_output_key;
+            changes->changed |= WM_VIEW_DIRTY_OUTPUT;
+        }
     }
 
-    int offset_x, offset_y;
-    wm_view_get_offset(view->view, &offset_x, &offset_y);
+    view->upstream.valid = true;
 
-    bool shows_csd = wm_view_shows_csd(view->view);
+    return changes->changed != 0;
+}
 
-    PyObject* args = Py_BuildValue(
-            "(lOiiOOOOOOOOiiOi)",
+PyObject* _pywm_view_changes_build_args(struct _pywm_view_changes* changes){
+    PyObject* args_general = NULL;
+    PyObject* args_size = NULL;
+    PyObject* args_mapped = NULL;
+    PyObject* args_state = NULL;
+    PyObject* args_size_constraints = NULL;
+    PyObject* args_offset = NULL;
+    PyObject* args_shows_csd = NULL;
+    PyObject* args_fixed_output_key = NULL;
+
+    if(changes->changed & WM_VIEW_DIRTY_INFO){
+        args_general = Py_BuildValue(
+                "(lOisss)",
+                changes->parent_handle,
+                changes->xwayland ? Py_True : Py_False,
+                changes->pid,
+                changes->app_id,
+                changes->role,
+                changes->title);
+    }
+
+    if(changes->changed & WM_VIEW_DIRTY_SIZE){
+        args_size = Py_BuildValue("(ii)", changes->width, changes->height);
+    }
+
+    if(changes->changed & WM_VIEW_DIRTY_MAPPED){
+        args_mapped = PyBool_FromLong(changes->mapped);
+    }
 
-            view->handle,
-            args_general,
+    if(changes->changed & WM_VIEW_DIRTY_STATE){
+        args_state = Py_BuildValue("(OOOOOO)",
+                changes->floating ? Py_True : Py_False,
+                changes->focused ? Py_True : Py_False,
+                changes->fullscreen ? Py_True : Py_False,
+                changes->maximized ? Py_True : Py_False,
+                changes->resizing ? Py_True : Py_False,
+                changes->inhibiting_idle ? Py_True : Py_False);
+    }
 
-            width,
-            height,
+    if(changes->changed & WM_VIEW_DIRTY_SIZE_CONSTRAINTS){
+        args_size_constraints = PyList_New(changes->n_size_constraints);
+        for (int i=0; i<changes->n_size_constraints; i++){
+            PyObject* cur = Py_BuildValue("i", changes->size_constraints[i]);
+            PyList_SetItem(args_size_constraints, i, cur);
+        }
+    }
 
-            is_mapped ? Py_True : Py_False,
-            is_floating ? Py_True : Py_False,
-            is_focused ? Py_True : Py_False,
-            is_fullscreen ? Py_True : Py_False,
-            is_maximized ? Py_True : Py_False,
-            is_resizing ? Py_True : Py_False,
-            is_inhibiting_idle ? Py_True : Py_False,
+    if(changes->changed & WM_VIEW_DIRTY_OFFSET){
+        args_offset = Py_BuildValue("(ii)", changes->offset_x, changes->offset_y);
+    }
 
-            args_size_constraints,
+    if(changes->changed & WM_VIEW_DIRTY_CSD){
+        args_shows_csd = PyBool_FromLong(changes->shows_csd);
+    }
 
-            offset_x,
-            offset_y,
-            shows_csd ? Py_True : Py_False,
-            fixed_output_key);
+    if(changes->changed & WM_VIEW_DIRTY_OUTPUT){
+        args_fixed_output_key = PyLong_FromLong(changes->fixed_output_key);
+    }
 
+    /* N steals the references, so pass new references to None */
+#define _PYWM_ARG(arg) ((arg) ? (arg) : (Py_INCREF(Py_None), Py_None))
+    PyObject* args = Py_BuildValue(
+            "(lNNNNNNNN)",
+            changes->handle,
+            _PYWM_ARG(args_general),
+            _PYWM_ARG(args_size),
+            _PYWM_ARG(args_mapped),
+            _PYWM_ARG(args_state),
+            _PYWM_ARG(args_size_constraints),
+            _PYWM_ARG(args_offset),
+            _PYWM_ARG(args_shows_csd),
+            _PYWM_ARG(args_fixed_output_key));
+#undef _PYWM_ARG
+
+    return args;
+}
 
+void _pywm_view_changes_finish(struct _pywm_view_changes* changes){
+    free(changes->title);
+    free(changes->app_id);
+    free(changes->role);
+    free(changes->size_constraints);
+    changes->title = NULL;
+    changes->app_id = NULL;
+    changes->role = NULL;
+    changes->size_constraints = NULL;
+}
 
+/*
+ * Arguments to update_view: handle followed by the parts of the upstream state,
+ * each of which is None if unchanged since the last call. *changed is false if
+ * all of them are None
+ */
+static PyObject* _pywm_view_build_args(struct _pywm_view* view, bool* changed){
+    struct _pywm_view_changes changes;
+    *changed = _pywm_view_collect_changes(view, &changes);
+    PyObject* args = _pywm_view_changes_build_args(&changes);
+    _pywm_view_changes_finish(&changes);
+    return args;
+}
+
+static void _pywm_view_apply(struct _pywm_view* view, struct _pywm_view_downstream* state){
+    struct wm_output* fixed_output = wm_content_get_output(&view->view->super);
+    int fixed_output_key = fixed_output ? fixed_output->key : -1;
+
+    wm_content_set_opacity(&view->view->super, state->opacity);
+    wm_content_set_mask(&view->view->super, state->mask_x, state->mask_y, state->mask_w, state->mask_h);
+    wm_content_set_corner_radius(&view->view->super, state->corner_radius);
+    if(state->floating >= 0)
+        wm_view_set_floating(view->view, state->floating);
+    wm_content_set_box(&view->view->super, state->x, state->y, state->w, state->h);
+
+    /* Set output before triggering configure in request_size */
+    if(state->fixed_output_key != fixed_output_key)
+        wm_content_set_output(&view->view->super, state->fixed_output_key, NULL);
+
+    if(state->width_pending > 0 && state->height_pending > 0)
+        wm_view_request_size(view->view, state->width_pending, state->height_pending);
+
+    if(state->focus_pending != -1 && state->focus_pending)
+        wm_focus_view(view->view);
+    if(state->resizing_pending != -1)
+        wm_view_set_resizing(view->view, state->resizing_pending);
+    if(state->fullscreen_pending != -1)
+        wm_view_set_fullscreen(view->view, state->fullscreen_pending);
+    if(state->maximized_pending != -1)
+        wm_view_set_maximized(view->view, state->maximized_pending);
+    if(state->close_pending != -1 && state->close_pending)
+        wm_view_request_close(view->view);
+    wm_content_set_z_index(&view->view->super, state->z_index);
+    wm_content_set_lock_enabled(&view->view->super, state->lock_enabled);
+
+    view->view->accepts_input = state->accepts_input;
+    wm_content_set_workspace(&view->view->super, state->workspace_x, state->workspace_y, state->workspace_w, state->workspace_h);
+}
+
+void _pywm_view_update(struct _pywm_view* view){
+    bool changed;
+    PyObject* args = _pywm_view_build_args(view, &changed);
     PyObject* res = PyObject_Call(_pywm_callbacks_get_all()->update_view, args, NULL);
-    if(args_general != Py_None)
-        Py_XDECREF(args_general);
-    Py_XDECREF(args_size_constraints);
     Py_XDECREF(args);
 
-    if(res && res != Py_None){
-        double x, y, w, h;
-        double opacity;
-        double mask_x, mask_y, mask_w, mask_h;
-        double corner_radius;
-        int floating, focus_pending, resizing_pending, fullscreen_pending, maximized_pending, close_pending;
-        int width_pending, height_pending;
-        int accepts_input;
-        double z_index;
-        int lock_enabled;
-        int new_fixed_output_key;
-        double workspace_x, workspace_y, workspace_w, workspace_h;
-        
+    /* None if the callback raised (and logged) */
+    if(!res || res == Py_None){
+        if(PyErr_Occurred()) PyErr_Print();
+
+        /* Python has not seen the changes - resend the full state */
+        view->upstream.valid = false;
+    }else{
+        struct _pywm_view_downstream state;
         if(!PyArg_ParseTuple(res, 
                     "(dddd)(dddd)dddppi(ii)iiiiii(dddd)",
-                    &x, &y, &w, &h,
-                    &mask_x, &mask_y, &mask_w, &mask_h,
-                    &opacity,
-                    &corner_radius,
-
-                    &z_index,
-                    &accepts_input,
-                    &lock_enabled,
-                    &floating,
-
-                    &width_pending, &height_pending,
-                    &focus_pending,
-                    &fullscreen_pending,
-                    &maximized_pending,
-                    &resizing_pending,
-                    &close_pending,
-                    &new_fixed_output_key,
-                    &workspace_x, &workspace_y, &workspace_w, &workspace_h
+                    &state.x, &state.y, &state.w, &state.h,
+                    &state.mask_x, &state.mask_y, &state.mask_w, &state.mask_h,
+                    &state.opacity,
+                    &state.corner_radius,
+
+                    &state.z_index,
+                    &state.accepts_input,
+                    &state.lock_enabled,
+                    &state.floating,
+
+                    &state.width_pending, &state.height_pending,
+                    &state.focus_pending,
+                    &state.fullscreen_pending,
+                    &state.maximized_pending,
+                    &state.resizing_pending,
+                    &state.close_pending,
+                    &state.fixed_output_key,
+                    &state.workspace_x, &state.workspace_y, &state.workspace_w, &state.workspace_h
         )){
             fprintf(stderr, "Error parsing update view return...\n");
-            PyErr_SetString(PyExc_TypeError, "Cannot parse update_view return");
+            PyErr_Print();
+            view->upstream.valid = false;
         }else{
-
-            wm_content_set_opacity(&view->view->super, opacity);
-            wm_content_set_mask(&view->view->super, mask_x, mask_y, mask_w, mask_h);
-            wm_content_set_corner_radius(&view->view->super, corner_radius);
-            if(floating >= 0)
-                wm_view_set_floating(view->view, floating);
-            wm_content_set_box(&view->view->super, x, y, w, h);
-
-            /* Set output before triggering configure in request_size */
-            if(new_fixed_output_key != fixed_output_key)
-                wm_content_set_output(&view->view->super, new_fixed_output_key, NULL);
-
-            if(width_pending > 0 && height_pending > 0)
-                wm_view_request_size(view->view, width_pending, height_pending);
-
-            if(focus_pending != -1 && focus_pending)
-                wm_focus_view(view->view);
-            if(resizing_pending != -1)
-                wm_view_set_resizing(view->view, resizing_pending);
-            if(fullscreen_pending != -1)
-                wm_view_set_fullscreen(view->view, fullscreen_pending);
-            if(maximized_pending != -1)
-                wm_view_set_maximized(view->view, maximized_pending);
-            if(close_pending != -1 && close_pending)
-                wm_view_request_close(view->view);
-            wm_content_set_z_index(&view->view->super, z_index);
-            wm_content_set_lock_enabled(&view->view->super, lock_enabled);
-
-            view->view->accepts_input = accepts_input;
-            wm_content_set_workspace(&view->view->super, workspace_x, workspace_y, workspace_w, workspace_h);
+            _pywm_view_apply(view, &state);
         }
 
     }
@@ -240,6 +419,7 @@ long _pywm_views_remove(struct wm_view* view){
 
     if(remove){
         long handle = remove->handle;
+        free(remove->upstream.size_constraints);
         free(remove);
 
         return handle;
@@ -266,6 +446,119 @@ void _pywm_views_update(){
     }
 }
 
+PyObject* _pywm_views_update_args(){
+    PyObject* list = PyList_New(0);
+    for(struct _pywm_view* view=views.first_view; view; view=view->next_view){
+        /* Views without upstream changes are only updated if damaged on the python side */
+        if(view->upstream.valid && !view->view->dirty) continue;
+
+        bool changed;
+        PyObject* args = _pywm_view_build_args(view, &changed);
+        if(changed){
+            PyList_Append(list, args);
+        }
+        Py_DECREF(args);
+    }
+    return list;
+}
+
+int _pywm_views_collect_changes(struct _pywm_view_changes** changes, int* size_changes){
+    int n = 0;
+    for(struct _pywm_view* view=views.first_view; view; view=view->next_view){
+        if(view->upstream.valid && !view->view->dirty) continue;
+
+        if(n == *size_changes){
+            *size_changes = *size_changes ? 2 * *size_changes : 8;
+            *changes = realloc(*changes, *size_changes * sizeof(struct _pywm_view_changes));
+            assert(*changes);
+        }
+        if(_pywm_view_collect_changes(view, &(*changes)[n])){
+            n++;
+        }else{
+            _pywm_view_changes_finish(&(*changes)[n]);
+        }
+    }
+    return n;
+}
+
+bool _pywm_views_update_apply(const void* data, long size){
+    struct _pywm_packed packed;
+    _pywm_packed_init(&packed, data, size);
+
+    struct _pywm_view* view = views.first_view;
+    while(packed.pos < packed.size){
+        long handle = _pywm_packed_long(&packed);
+        int valid = _pywm_packed_int(&packed);
+
+        struct _pywm_view_downstream state;
+        state.x = _pywm_packed_double(&packed);
+        state.y = _pywm_packed_double(&packed);
+        state.w = _pywm_packed_double(&packed);
+        state.h = _pywm_packed_double(&packed);
+        state.mask_x = _pywm_packed_double(&packed);
+        state.mask_y = _pywm_packed_double(&packed);
+        state.mask_w = _pywm_packed_double(&packed);
+        state.mask_h = _pywm_packed_double(&packed);
+        state.opacity = _pywm_packed_double(&packed);
+        state.corner_radius = _pywm_packed_double(&packed);
+        state.z_index = _pywm_packed_double(&packed);
+        state.accepts_input = _pywm_packed_int(&packed);
+        state.lock_enabled = _pywm_packed_int(&packed);
+        state.floating = _pywm_packed_int(&packed);
+        state.width_pending = _pywm_packed_int(&packed);
+        state.height_pending = _pywm_packed_int(&packed);
+        state.focus_pending = _pywm_packed_int(&packed);
+        state.fullscreen_pending = _pywm_packed_int(&packed);
+        state.maximized_pending = _pywm_packed_int(&packed);
+        state.resizing_pending = _pywm_packed_int(&packed);
+        state.close_pending = _pywm_packed_int(&packed);
+        state.fixed_output_key = _pywm_packed_int(&packed);
+        state.workspace_x = _pywm_packed_double(&packed);
+        state.workspace_y = _pywm_packed_double(&packed);
+        state.workspace_w = _pywm_packed_double(&packed);
+        state.workspace_h = _pywm_packed_double(&packed);
+
+        if(packed.error){
+            return false;
+        }
+
+        /* Records are mostly in the order of views, but only contain the updated ones */
+        struct _pywm_view* start = view;
+        for(; view && view->handle != handle; view=view->next_view);
+        if(!view){
+            for(view=views.first_view; view != start && view->handle != handle; view=view->next_view);
+            if(view == start) view = NULL;
+        }
+        if(!view) continue;
+
+        if(valid){
+            _pywm_view_apply(view, &state);
+        }else{
+            /* Update failed on the python side, which might not have seen the changes */
+            view->upstream.valid = false;
+        }
+        view = view->next_view;
+    }
+
+    return true;
+}
+
+void _pywm_views_invalidate_upstream(long handle){
+    for(struct _pywm_view* v=views.first_view; v; v=v->next_view){
+        if(v->handle == handle){
+            v->upstream.valid = false;
+            break;
+        }
+    }
+}
+
+void _pywm_views_invalidate_args(PyObject* list){
+    for(Py_ssize_t i=0; i<PyList_Size(list); i++){
+        PyObject* handle = PyTuple_GetItem(PyList_GetItem(list, i), 0);
+        if(handle) _pywm_views_invalidate_upstream(PyLong_AsLong(handle));
+    }
+}
+
 void _pywm_views_update_single(struct wm_view* view){
     for(struct _pywm_view* v=views.first_view; v; v=v->next_view){
         if(v->view == view){
@@ -9,13 +9,15 @@
 #include "wm/wm_composite.h"
 #include "py/_pywm_widget.h"
 #include "py/_pywm_callbacks.h"
+#include "py/_pywm_packed.h"
+#include "py/_pywm_buffer.h"
 #include "wm/wm_util.h"
 
 static struct _pywm_widgets widgets = { 0 };
 static long next_handle = 1;
 
-void _pywm_widget_init(struct _pywm_widget* _widget, struct wm_widget* widget, struct wm_composite* composite){
-    _widget->handle = (next_handle++);
+void _pywm_widget_init(struct _pywm_widget* _widget, struct wm_widget* widget, struct wm_composite* composite, long handle){
+    _widget->handle = handle;
     _widget->widget = widget;
     _widget->composite = composite;
 
@@ -25,101 +27,227 @@ void _pywm_widget_init(struct _pywm_widget* _widget, struct wm_widget* widget, s
     _widget->next_widget = NULL;
 }
 
+struct _pywm_widget_downstream {
+    int lock_enabled;
+    double x, y, w, h;
+    double mask_x, mask_y, mask_w, mask_h;
+    int output_key;
+    double opacity;
+    double corner_radius;
+    double z_index;
+    double workspace_x, workspace_y, workspace_w, workspace_h;
+};
+
+static void _pywm_widget_apply(struct _pywm_widget* widget, struct _pywm_widget_downstream* state){
+    wm_content_set_opacity(widget->super, state->opacity);
+    wm_content_set_corner_radius(widget->super, state->corner_radius);
+    if(state->w >= 0.0 && state->h >= 0.0)
+        wm_content_set_box(widget->super, state->x, state->y, state->w, state->h);
+    wm_content_set_mask(widget->super, state->mask_x, state->mask_y, state->mask_w, state->mask_h);
+    wm_content_set_z_index(widget->super, state->z_index);
+    wm_content_set_lock_enabled(widget->super, state->lock_enabled);
+
+    wm_content_set_output(widget->super, state->output_key, NULL);
+    wm_content_set_workspace(widget->super, state->workspace_x, state->workspace_y, state->workspace_w, state->workspace_h);
+}
+
+/*
+ * pixels is either a PixelBuffer or (stride, width, height, bytes), optionally
+ * wrapped as (pixels, (x, y, width, height)) if only this rectangle has changed
+ */
+static bool _pywm_widget_payload_parse_pixels(struct _pywm_widget_payload* payload, PyObject* pixels){
+    if(!pixels || pixels == Py_None) return true;
+
+    PyObject* ref = pixels;
+    if(PyTuple_Check(pixels) && PyTuple_Size(pixels) == 2){
+        if(!PyArg_ParseTuple(pixels, "O(iiii)", &pixels,
+                    &payload->region_x, &payload->region_y, &payload->region_width, &payload->region_height)){
+            PyErr_SetString(PyExc_TypeError, "Cannot parse pixels region");
+            return false;
+        }
+        payload->partial = true;
+    }
+
+    if(_pywm_buffer_check(pixels)){
+        struct _pywm_buffer* buffer = (struct _pywm_buffer*)pixels;
+        payload->stride = buffer->stride;
+        payload->width = buffer->width;
+        payload->height = buffer->height;
+        payload->data = buffer->data;
+        payload->buffer = buffer;
+    }else{
+        PyObject* bytes;
+        if(!PyArg_ParseTuple(pixels, "iiiS", &payload->stride, &payload->width, &payload->height, &bytes)){
+            PyErr_SetString(PyExc_TypeError, "Cannot parse pixels");
+            return false;
+        }
+        payload->data = PyBytes_AsString(bytes);
+    }
+
+    /* Keeps data alive */
+    payload->pixels_ref = ref;
+    Py_INCREF(ref);
+    return true;
+}
+
+static bool _pywm_widget_payload_parse_primitive(struct _pywm_widget_payload* payload, PyObject* primitive){
+    if(!primitive || primitive == Py_None) return true;
+
+    char* name;
+    PyObject* params_int;
+    PyObject* params_float;
+    if(!PyArg_ParseTuple(primitive, "sOO", &name, &params_int, &params_float)){
+        PyErr_SetString(PyExc_TypeError, "Cannot parse primitive");
+        return false;
+    }
+
+    if(!params_int || !params_float || !PyList_Check(params_int) || !PyList_Check(params_float)){
+        PyErr_SetString(PyExc_TypeError, "Cannot parse primitive lists");
+        return false;
+    }
+
+    payload->n_params_int = PyList_Size(params_int);
+    payload->n_params_float = PyList_Size(params_float);
+    payload->params_int = malloc(payload->n_params_int * sizeof(int));
+    payload->params_float = malloc(payload->n_params_float * sizeof(float));
+
+    for(int i=0; i<payload->n_params_int; i++){
+        payload->params_int[i] = PyLong_AsLong(PyList_GetItem(params_int, i));
+    }
+    for(int i=0; i<payload->n_params_float; i++){
+        payload->params_float[i] = PyFloat_AsDouble(PyList_GetItem(params_float, i));
+    }
+
+    payload->primitive = strdup(name);
+    return true;
+}
+
+bool _pywm_widget_payload_parse(struct _pywm_widget_payload* payload, long handle, PyObject* pixels, PyObject* primitive){
+    *payload = (struct _pywm_widget_payload){ 0 };
+    payload->handle = handle;
+
+    if(!_pywm_widget_payload_parse_pixels(payload, pixels) ||
+            !_pywm_widget_payload_parse_primitive(payload, primitive)){
+        _pywm_widget_payload_release(payload);
+        return false;
+    }
+    return true;
+}
+
+void _pywm_widget_payload_apply(struct _pywm_widget* widget, struct _pywm_widget_payload* payload){
+    if(payload->data && widget->widget){
+        if(payload->partial){
+            wm_widget_set_pixels_region(widget->widget,
+                    DRM_FORMAT_ARGB8888,
+                    payload->stride,
+                    payload->width,
+                    payload->height,
+                    payload->data,
+                    payload->region_x, payload->region_y, payload->region_width, payload->region_height);
+        }else{
+            wm_widget_set_pixels(widget->widget,
+                    DRM_FORMAT_ARGB8888,
+                    payload->stride,
+                    payload->width,
+                    payload->height,
+                    payload->data);
+        }
+    }
+
+    /* Parameters are passed on */
+    if(payload->primitive){
+        if(widget->widget){
+            wm_widget_set_primitive(widget->widget, payload->primitive,
+                    payload->n_params_int, payload->params_int, payload->n_params_float, payload->params_float);
+        }else{
+            wm_composite_set_type(widget->composite, payload->primitive,
+                    payload->n_params_int, payload->params_int, payload->n_params_float, payload->params_float);
+            free(payload->primitive);
+        }
+        payload->primitive = NULL;
+        payload->params_int = NULL;
+        payload->params_float = NULL;
+    }
+}
+
+void _pywm_widget_payload_release(struct _pywm_widget_payload* payload){
+    Py_XDECREF(payload->pixels_ref);
+    payload->pixels_ref = NULL;
+    payload->buffer = NULL;
+    payload->data = NULL;
+
+    free(payload->primitive);
+    free(payload->params_int);
+    free(payload->params_float);
+    payload->primitive = NULL;
+    payload->params_int = NULL;
+    payload->params_float = NULL;
+}
+
+bool _pywm_widget_payload_snapshot(struct _pywm_widget_payload* payload){
+    /* bytes are immutable */
+    if(!payload->buffer) return true;
+
+    if(payload->partial){
+        payload->data = _pywm_buffer_snapshot(payload->buffer,
+                payload->region_x, payload->region_y, payload->region_width, payload->region_height);
+    }else{
+        payload->data = _pywm_buffer_snapshot(payload->buffer, 0, 0, payload->width, payload->height);
+    }
+    if(!payload->data){
+        PyErr_NoMemory();
+        return false;
+    }
+    return true;
+}
+
+static bool _pywm_widget_apply_payload(struct _pywm_widget* widget, PyObject* pixels, PyObject* primitive){
+    struct _pywm_widget_payload payload;
+    if(!_pywm_widget_payload_parse(&payload, widget->handle, pixels, primitive)){
+        return false;
+    }
+
+    _pywm_widget_payload_apply(widget, &payload);
+    _pywm_widget_payload_release(&payload);
+    return true;
+}
+
 void _pywm_widget_update(struct _pywm_widget* widget){
     PyObject* args = Py_BuildValue("(l)", widget->handle);
     PyObject* res = PyObject_Call(_pywm_callbacks_get_all()->update_widget, args, NULL);
     Py_XDECREF(args);
+
+    /* None: unchanged since the last update */
     if(res && res != Py_None){
-        double x, y, w, h;
-        double mask_x, mask_y, mask_w, mask_h;
-        int output_key;
-        double opacity;
-        double corner_radius;
-        double z_index;
-        int lock_enabled;
-        double workspace_x, workspace_y, workspace_w, workspace_h;
+        struct _pywm_widget_downstream state;
         PyObject* pixels;
         PyObject* primitive;
         if(!PyArg_ParseTuple(res, 
                     "p(dddd)(dddd)iddd(dddd)OO",
-                    &lock_enabled,
-                    &x, &y, &w, &h,
-                    &mask_x, &mask_y, &mask_w, &mask_h,
-                    &output_key,
-                    &opacity,
-                    &corner_radius,
-                    &z_index,
-                    &workspace_x, &workspace_y, &workspace_w, &workspace_h, &pixels, &primitive
+                    &state.lock_enabled,
+                    &state.x, &state.y, &state.w, &state.h,
+                    &state.mask_x, &state.mask_y, &state.mask_w, &state.mask_h,
+                    &state.output_key,
+                    &state.opacity,
+                    &state.corner_radius,
+                    &state.z_index,
+                    &state.workspace_x, &state.workspace_y, &state.workspace_w, &state.workspace_h, &pixels, &primitive
            )){
             PyErr_SetString(PyExc_TypeError, "Cannot parse update_widget return");
             return;
         }
 
-        wm_content_set_opacity(widget->super, opacity);
-        wm_content_set_corner_radius(widget->super, corner_radius);
-        if(w >= 0.0 && h >= 0.0)
-            wm_content_set_box(widget->super, x, y, w, h);
-        wm_content_set_mask(widget->super, mask_x, mask_y, mask_w, mask_h);
-        wm_content_set_z_index(widget->super, z_index);
-        wm_content_set_lock_enabled(widget->super, lock_enabled);
-
-        wm_content_set_output(widget->super, output_key, NULL);
-        wm_content_set_workspace(widget->super, workspace_x, workspace_y, workspace_w, workspace_h);
-
-        if(pixels && pixels != Py_None && widget->widget){
-            int stride, width, height;
-            PyObject* data;
-            if(!PyArg_ParseTuple(pixels, "iiiS", &stride, &width, &height, &data)){
-                PyErr_SetString(PyExc_TypeError, "Cannot parse pixels");
-                return;
-            }
-
-            wm_widget_set_pixels(widget->widget,
-                    DRM_FORMAT_ARGB8888,
-                    stride,
-                    width,
-                    height,
-                    PyBytes_AsString(data));
-        }
-
-        if(primitive && primitive != Py_None){
-            char* name;
-            PyObject* params_int;
-            PyObject* params_float;
-            if(!PyArg_ParseTuple(primitive, "sOO", &name, &params_int, &params_float)){
-                PyErr_SetString(PyExc_TypeError, "Cannot parse primitive");
-                return;
-            }
-
-            if(!params_int || !params_float || !PyList_Check(params_int) || !PyList_Check(params_float)){
-                PyErr_SetString(PyExc_TypeError, "Cannot parse primitive lists");
-                return;
-            }
-
-            int* p_int = malloc(PyList_Size(params_int) * sizeof(int));
-            float* p_float = malloc(PyList_Size(params_float) * sizeof(int));
-
-            for(int i=0; i<PyList_Size(params_int); i++){
-                p_int[i] = PyLong_AsLong(PyList_GetItem(params_int, i));
-            }
-            for(int i=0; i<PyList_Size(params_float); i++){
-                p_float[i] = PyFloat_AsDouble(PyList_GetItem(params_float, i));
-            }
-
-            if(widget->widget){
-                wm_widget_set_primitive(widget->widget, strdup(name), PyList_Size(params_int), p_int, PyList_Size(params_float), p_float);
-            }else{
-                wm_composite_set_type(widget->composite, name, PyList_Size(params_int), p_int, PyList_Size(params_float), p_float);
-            }
+        _pywm_widget_apply(widget, &state);
 
+        if(!_pywm_widget_apply_payload(widget, pixels, primitive)){
+            return;
         }
-
     }
 
     Py_XDECREF(res);
 }
 
-long _pywm_widgets_add(struct wm_widget* widget, struct wm_composite* composite){
+long _pywm_widgets_add(struct wm_widget* widget, struct wm_composite* composite, long handle){
     struct _pywm_widget* it;
     for(it = widgets.first_widget; it && it->next_widget; it=it->next_widget);
     struct _pywm_widget** insert;
@@ -130,7 +258,7 @@ long _pywm_widgets_add(struct wm_widget* widget, struct wm_composite* composite)
     }
 
     *insert = malloc(sizeof(struct _pywm_widget));
-    _pywm_widget_init(*insert, widget, composite);
+    _pywm_widget_init(*insert, widget, composite, handle);
     return (*insert)->handle;
 }
 
@@ -164,7 +292,11 @@ long _pywm_widgets_get_handle(struct wm_content* content){
 }
 
 
-void _pywm_widgets_update(){
+void _pywm_widgets_query_structure(long* destroy_handle, long* new_handle, int* new_type){
+    *destroy_handle = 0;
+    *new_handle = 0;
+    *new_type = 0;
+
     /* Query for a widget to destroy */
     PyObject* args = Py_BuildValue("()");
     PyObject* res = PyObject_Call(_pywm_callbacks_get_all()->query_destroy_widget, args, NULL);
@@ -173,16 +305,9 @@ void _pywm_widgets_update(){
         long handle = PyLong_AsLong(res);
         if(handle < 0){
             PyErr_SetString(PyExc_TypeError, "Expected long");
-            goto err;
-        }
-
-        struct wm_content* content = _pywm_widgets_from_handle(handle);
-        if(!content){
-            PyErr_SetString(PyExc_TypeError, "Widget has been destroyed");
-            goto err;
+        }else{
+            *destroy_handle = handle;
         }
-        _pywm_widgets_remove(content);
-        wm_content_destroy(content);
     }
     Py_XDECREF(res);
 
@@ -192,17 +317,45 @@ void _pywm_widgets_update(){
     Py_XDECREF(args);
     if(res && res != Py_None){
         long r = PyLong_AsLong(res);
-        if(r == 1){
-            struct wm_widget* widget = calloc(1, sizeof(struct wm_widget));
-            wm_widget_init(widget, get_wm()->server);
-            _pywm_widgets_add(widget, NULL);
-        }else if(r == 2){
-            struct wm_composite* composite = calloc(1, sizeof(struct wm_composite));
-            wm_composite_init(composite, get_wm()->server);
-            _pywm_widgets_add(NULL, composite);
+        if(r == 1 || r == 2){
+            *new_handle = next_handle++;
+            *new_type = r;
         }
     }
     Py_XDECREF(res);
+}
+
+void _pywm_widgets_apply_structure(long destroy_handle, long new_handle, int new_type){
+    if(destroy_handle > 0){
+        struct wm_content* content = _pywm_widgets_from_handle(destroy_handle);
+        if(!content){
+            wlr_log(WLR_ERROR, "Widget %ld has been destroyed", destroy_handle);
+        }else{
+            _pywm_widgets_remove(content);
+            wm_content_destroy(content);
+        }
+    }
+
+    if(new_type == 1){
+        struct wm_widget* widget = calloc(1, sizeof(struct wm_widget));
+        wm_widget_init(widget, get_wm()->server);
+        _pywm_widgets_add(widget, NULL, new_handle);
+    }else if(new_type == 2){
+        struct wm_composite* composite = calloc(1, sizeof(struct wm_composite));
+        wm_composite_init(composite, get_wm()->server);
+        _pywm_widgets_add(NULL, composite, new_handle);
+    }
+}
+
+void _pywm_widgets_update_structure(){
+    long destroy_handle, new_handle;
+    int new_type;
+    _pywm_widgets_query_structure(&destroy_handle, &new_handle, &new_type);
+    _pywm_widgets_apply_structure(destroy_handle, new_handle, new_type);
+}
+
+void _pywm_widgets_update(){
+    _pywm_widgets_update_structure();
 
     /* Update existing widgets */
     for(struct _pywm_widget* widget = widgets.first_widget; widget; widget=widget->next_widget){
@@ -211,9 +364,89 @@ void _pywm_widgets_update(){
         TIMER_STOP(callback_update_widgets_single);
         TIMER_PRINT(callback_update_widgets_single);
     }
+}
 
-err:
-    ;
+bool _pywm_widgets_update_apply_states(const void* data, long size){
+    struct _pywm_packed packed;
+    _pywm_packed_init(&packed, data, size);
+
+    struct _pywm_widget* widget = widgets.first_widget;
+    while(packed.pos < packed.size){
+        long handle = _pywm_packed_long(&packed);
+        int valid = _pywm_packed_int(&packed);
+
+        struct _pywm_widget_downstream state;
+        state.lock_enabled = _pywm_packed_int(&packed);
+        state.x = _pywm_packed_double(&packed);
+        state.y = _pywm_packed_double(&packed);
+        state.w = _pywm_packed_double(&packed);
+        state.h = _pywm_packed_double(&packed);
+        state.mask_x = _pywm_packed_double(&packed);
+        state.mask_y = _pywm_packed_double(&packed);
+        state.mask_w = _pywm_packed_double(&packed);
+        state.mask_h = _pywm_packed_double(&packed);
+        state.output_key = _pywm_packed_int(&packed);
+        state.opacity = _pywm_packed_double(&packed);
+        state.corner_radius = _pywm_packed_double(&packed);
+        state.z_index = _pywm_packed_double(&packed);
+        state.workspace_x = _pywm_packed_double(&packed);
+        state.workspace_y = _pywm_packed_double(&packed);
+        state.workspace_w = _pywm_packed_double(&packed);
+        state.workspace_h = _pywm_packed_double(&packed);
+
+        if(packed.error){
+            return false;
+        }
+
+        /* Records only contain changed widgets, mostly in the order of widgets */
+        if(!widget || widget->handle != handle){
+            widget = _pywm_widgets_container_from_handle(handle);
+        }
+        if(!widget) continue;
+
+        if(valid) _pywm_widget_apply(widget, &state);
+        widget = widget->next_widget;
+    }
+
+    return true;
+}
+
+void _pywm_widgets_apply_payload(struct _pywm_widget_payload* payload){
+    struct _pywm_widget* target = _pywm_widgets_container_from_handle(payload->handle);
+    if(!target) return;
+
+    _pywm_widget_payload_apply(target, payload);
+}
+
+void _pywm_widgets_update_apply(const void* data, long size, PyObject* payloads){
+    if(!_pywm_widgets_update_apply_states(data, size)){
+        PyErr_SetString(PyExc_TypeError, "Cannot parse packed update_widget return");
+        return;
+    }
+
+    /* Pixels and primitives: list of (handle, pixels, primitive) */
+    if(!payloads || payloads == Py_None) return;
+    if(!PyList_Check(payloads)){
+        PyErr_SetString(PyExc_TypeError, "Cannot parse update_widget payloads");
+        return;
+    }
+
+    for(int i=0; i<PyList_Size(payloads); i++){
+        long handle;
+        PyObject* pixels;
+        PyObject* primitive;
+        if(!PyArg_ParseTuple(PyList_GetItem(payloads, i), "lOO", &handle, &pixels, &primitive)){
+            PyErr_SetString(PyExc_TypeError, "Cannot parse update_widget payload");
+            return;
+        }
+
+        struct _pywm_widget* target = _pywm_widgets_container_from_handle(handle);
+        if(!target) continue;
+
+        if(!_pywm_widget_apply_payload(target, pixels, primitive)){
+            return;
+        }
+    }
 }
 
 
@@ -9,10 +9,13 @@
 #include "wm/wm_config.h"
 #include "wm/wm_server.h"
 #include "wm/wm_layout.h"
+#include "wm/wm_output.h"
 #include "wm/wm_util.h"
 #include "py/_pywm_callbacks.h"
 #include "py/_pywm_view.h"
 #include "py/_pywm_widget.h"
+#include "py/_pywm_buffer.h"
+#include "py/_pywm_async.h"
 
 static void sig_handler(int sig) {
     void *array[10];
@@ -43,6 +46,7 @@ static void set_config(struct wm_config* conf, PyObject* dict, int reconfigure){
             int pos_x = WM_CONFIG_POS_MIN - 1;
             int pos_y = WM_CONFIG_POS_MIN - 1;
             int transform = 0;
+            int max_render_time = 0;
 
             o = PyDict_GetItemString(c, "name"); if(o){ name = PyBytes_AsString(o); }
             o = PyDict_GetItemString(c, "scale"); if(o){ scale = PyFloat_AsDouble(o); }
@@ -52,8 +56,9 @@ static void set_config(struct wm_config* conf, PyObject* dict, int reconfigure){
             o = PyDict_GetItemString(c, "pos_x"); if(o){ pos_x = PyLong_AsLong(o); }
             o = PyDict_GetItemString(c, "pos_y"); if(o){ pos_y = PyLong_AsLong(o); }
             o = PyDict_GetItemString(c, "transform"); if(o){ transform = PyLong_AsLong(o); }
+            o = PyDict_GetItemString(c, "max_render_time"); if(o){ max_render_time = PyLong_AsLong(o); }
 
-            wm_config_add_output(conf, name, scale, width, height, mHz, pos_x, pos_y, transform);
+            wm_config_add_output(conf, name, scale, width, height, mHz, pos_x, pos_y, transform, max_render_time);
         }
     }
     o = PyDict_GetItemString(dict, "xkb_model"); if(o){ strncpy(conf->xkb_model, PyBytes_AsString(o), WM_CONFIG_STRLEN-1); }
@@ -74,6 +79,9 @@ static void set_config(struct wm_config* conf, PyObject* dict, int reconfigure){
     o = PyDict_GetItemString(dict, "tap_to_click"); if(o){ conf->tap_to_click = o == Py_True; }
     o = PyDict_GetItemString(dict, "natural_scroll"); if(o){ conf->natural_scroll = o == Py_True; }
 
+    o = PyDict_GetItemString(dict, "direct_scanout"); if(o){ conf->direct_scanout = o == Py_True; }
+    o = PyDict_GetItemString(dict, "frame_timing"); if(o){ conf->frame_timing = o == Py_True; }
+
     o = PyDict_GetItemString(dict, "enable_xwayland"); if(o){ conf->enable_xwayland = o == Py_True; }
     o = PyDict_GetItemString(dict, "debug"); if(o){ conf->debug = o == Py_True; }
 
@@ -85,7 +93,17 @@ static void set_config(struct wm_config* conf, PyObject* dict, int reconfigure){
 }
 
 
+static void apply_config(PyObject* config){
+    set_config(get_wm()->server->wm_config, config, 1);
+}
+
 static void handle_update_view(struct wm_view* view){
+    if(_pywm_async_enabled()){
+        /* Picked up by the next update */
+        wl_event_source_timer_update(get_wm()->server->callback_timer, 1);
+        return;
+    }
+
     PyGILState_STATE gil = PyGILState_Ensure();
     _pywm_views_update_single(view);
     /* Decoration widgets might depend on the view state */
@@ -93,7 +111,54 @@ static void handle_update_view(struct wm_view* view){
     PyGILState_Release(gil);
 }
 
+/*
+ * Update all views and widgets in one call instead of one per object; widgets are
+ * updated after views on the python side. Only changed views and widgets are passed
+ * in either direction. Widgets created during this call are updated on the next frame.
+ */
+static void handle_update_all(){
+    _pywm_widgets_update_structure();
+
+    PyObject* view_args = _pywm_views_update_args();
+    PyObject* args = Py_BuildValue("(O)", view_args);
+    PyObject* res = PyObject_Call(_pywm_callbacks_get_all()->update_all, args, NULL);
+    Py_XDECREF(args);
+
+    /* None if the callback raised (and logged) */
+    Py_buffer views;
+    Py_buffer widgets;
+    PyObject* payloads;
+    if(!res || res == Py_None || !PyArg_ParseTuple(res, "y*y*O", &views, &widgets, &payloads)){
+        if(PyErr_Occurred()){
+            wlr_log(WLR_ERROR, "Python error in update_all");
+            PyErr_Print();
+        }
+
+        /* Python has not seen these changes - resend the full state */
+        _pywm_views_invalidate_args(view_args);
+        Py_DECREF(view_args);
+        Py_XDECREF(res);
+        return;
+    }
+
+    if(!_pywm_views_update_apply(views.buf, views.len)){
+        wlr_log(WLR_ERROR, "Cannot parse packed update_view return");
+        _pywm_views_invalidate_args(view_args);
+    }
+    _pywm_widgets_update_apply(widgets.buf, widgets.len, payloads);
+
+    PyBuffer_Release(&views);
+    PyBuffer_Release(&widgets);
+    Py_DECREF(view_args);
+    Py_XDECREF(res);
+}
+
 static void handle_update(){
+    if(_pywm_async_enabled()){
+        _pywm_async_update();
+        return;
+    }
+
     PyGILState_STATE gil = PyGILState_Ensure();
 
     TIMER_START(callback_update_pywm);
@@ -144,16 +209,23 @@ static void handle_update(){
     TIMER_STOP(callback_update_pywm);
     TIMER_PRINT(callback_update_pywm);
 
-    TIMER_START(callback_update_views);
-    _pywm_views_update();
-    TIMER_STOP(callback_update_views);
-    TIMER_PRINT(callback_update_views);
-
-    /* State of widgets (e.g. decorations) might depend on views - other way round not possible, as widgets have no upstream state */
-    TIMER_START(callback_update_widgets);
-    _pywm_widgets_update();
-    TIMER_STOP(callback_update_widgets);
-    TIMER_PRINT(callback_update_widgets);
+    if(_pywm_callbacks_get_all()->update_all){
+        TIMER_START(callback_update_all);
+        handle_update_all();
+        TIMER_STOP(callback_update_all);
+        TIMER_PRINT(callback_update_all);
+    }else{
+        TIMER_START(callback_update_views);
+        _pywm_views_update();
+        TIMER_STOP(callback_update_views);
+        TIMER_PRINT(callback_update_views);
+
+        /* State of widgets (e.g. decorations) might depend on views - other way round not possible, as widgets have no upstream state */
+        TIMER_START(callback_update_widgets);
+        _pywm_widgets_update();
+        TIMER_STOP(callback_update_widgets);
+        TIMER_PRINT(callback_update_widgets);
+    }
 
 
     PyGILState_Release(gil);
@@ -175,8 +247,12 @@ static PyObject* _pywm_run(PyObject* self, PyObject* args, PyObject* kwargs){
     struct wm_config conf;
     wm_config_init_default(&conf);
 
+    bool threaded_update = false;
     if(kwargs){
         set_config(&conf, kwargs, 0);
+
+        PyObject* o = PyDict_GetItemString(kwargs, "threaded_update");
+        threaded_update = o == Py_True;
     }
 
     /* Register callbacks immediately, might be called during init */
@@ -186,8 +262,17 @@ static PyObject* _pywm_run(PyObject* self, PyObject* args, PyObject* kwargs){
 
     wm_init(&conf);
 
+    if(threaded_update){
+        if(_pywm_callbacks_get_all()->update_all){
+            _pywm_async_start(apply_config);
+        }else{
+            wlr_log(WLR_ERROR, "Threaded update requires update_all - falling back to synchronous update");
+        }
+    }
+
     Py_BEGIN_ALLOW_THREADS;
     status = wm_run();
+    _pywm_async_stop();
     Py_END_ALLOW_THREADS;
 
     wlr_log(WLR_INFO, "...finished\n");
@@ -251,12 +336,61 @@ static PyObject* _pywm_debugperformance(PyObject* self, PyObject* args){
     return Py_None;
 }
 
+struct frame_timings_copy {
+    int n_outputs;
+    int size_outputs;
+    int* output_keys;
+    int* n_frames;
+    struct wm_frame_timing* frames;
+};
+
+/* Copy with the lock held, python objects are built afterwards */
+static void copy_frame_timings(struct wm_frame_timings* timings, void* data){
+    struct frame_timings_copy* copy = data;
+    if(copy->n_outputs == copy->size_outputs){
+        copy->size_outputs = copy->size_outputs ? 2 * copy->size_outputs : 4;
+        copy->output_keys = realloc(copy->output_keys, copy->size_outputs * sizeof(int));
+        copy->n_frames = realloc(copy->n_frames, copy->size_outputs * sizeof(int));
+        copy->frames = realloc(copy->frames, copy->size_outputs * WM_OUTPUT_FRAME_TIMINGS * sizeof(struct wm_frame_timing));
+        assert(copy->output_keys && copy->n_frames && copy->frames);
+    }
+
+    int i = copy->n_outputs++;
+    copy->output_keys[i] = timings->output_key;
+    copy->n_frames[i] = wm_frame_timings_copy(timings, copy->frames + i * WM_OUTPUT_FRAME_TIMINGS);
+}
+
+static PyObject* _pywm_frame_timings(PyObject* self, PyObject* args){
+    PyObject* list = PyList_New(0);
+    if(!list) return NULL;
+
+    struct wm_server* server = get_wm()->server;
+    if(!server) return list;
+
+    struct frame_timings_copy copy = { 0 };
+    wm_server_frame_timings_foreach(server, copy_frame_timings, &copy);
+
+    for(int i=0; i<copy.n_outputs; i++){
+        PyObject* item = Py_BuildValue("(iN)", copy.output_keys[i],
+                PyBytes_FromStringAndSize((const char*)(copy.frames + i * WM_OUTPUT_FRAME_TIMINGS),
+                    copy.n_frames[i] * sizeof(struct wm_frame_timing)));
+        PyList_Append(list, item);
+        Py_XDECREF(item);
+    }
+
+    free(copy.output_keys);
+    free(copy.n_frames);
+    free(copy.frames);
+    return list;
+}
+
 
 static PyMethodDef _pywm_methods[] = {
     { "run",                       (PyCFunction)_pywm_run,           METH_VARARGS | METH_KEYWORDS,   "Start the compositor in this thread" },
     { "register",                  _pywm_register,                   METH_VARARGS,                   "Register callback"  },
     { "damage",                    _pywm_damage,                     METH_VARARGS,                   "Track damage, or set mode to continuous damage"  },
     { "debug_performance",         _pywm_debugperformance,           METH_VARARGS,                   "Debug uitlity - uses DEBUG_PERFORMANCE macro"  },
+    { "frame_timings",             _pywm_frame_timings,              METH_NOARGS,                    "Recent frames per output as list of (output key, packed records)"  },
 
     { NULL, NULL, 0, NULL }
 };
@@ -274,5 +408,19 @@ static struct PyModuleDef _pywm = {
 };
 
 PyMODINIT_FUNC PyInit__pywm(void){
-    return PyModule_Create(&_pywm);
+    if(PyType_Ready(&_pywm_buffer_type) < 0){
+        return NULL;
+    }
+
+    PyObject* module = PyModule_Create(&_pywm);
+    if(!module) return NULL;
+
+    Py_INCREF(&_pywm_buffer_type);
+    if(PyModule_AddObject(module, "PixelBuffer", (PyObject*)&_pywm_buffer_type) < 0){
+        Py_DECREF(&_pywm_buffer_type);
+        Py_DECREF(module);
+        return NULL;
+    }
+
+    return module;
 }
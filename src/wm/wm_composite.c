@@ -106,6 +106,14 @@ void wm_composite_on_damage_below(struct wm_composite* comp, struct wm_output* o
     wm_composite_get_effective_box(comp, output, &box);
 
     int extend = wm_composite_extend(comp);
+
+    /* Quick reject - damage does not reach the composite */
+    pixman_box32_t* extents = pixman_region32_extents(damage);
+    if(extents->x2 + extend <= box.x || extents->x1 - extend >= box.x + box.width ||
+            extents->y2 + extend <= box.y || extents->y1 - extend >= box.y + box.height){
+        return;
+    }
+
     int nrects;
     pixman_box32_t* rects = pixman_region32_rectangles(damage, &nrects);
     for(int i = 0; i < nrects; i++){
@@ -144,6 +152,30 @@ bool wm_content_is_composite(struct wm_content* content){
     return content->vtable == &wm_composite_vtable;
 }
 
+int wm_composite_list(struct wm_server* server, struct wm_composite*** result){
+    if(server->wm_composites_generation != server->wm_contents_generation){
+        /* wm_contents is always kept ordered, so no need to sort */
+        server->n_composites = 0;
+
+        struct wm_content* content;
+        wl_list_for_each(content, &server->wm_contents, link){
+            if(!wm_content_is_composite(content)) continue;
+
+            if(server->n_composites == server->size_composites){
+                server->size_composites = server->size_composites ? 2 * server->size_composites : 8;
+                server->wm_composites = realloc(server->wm_composites, server->size_composites * sizeof(struct wm_composite*));
+                assert(server->wm_composites);
+            }
+            server->wm_composites[server->n_composites++] = wm_cast(wm_composite, content);
+        }
+
+        server->wm_composites_generation = server->wm_contents_generation;
+    }
+
+    *result = server->wm_composites;
+    return server->n_composites;
+}
+
 static void wm_composite_printf(FILE* file, struct wm_content* super){
     struct wm_composite* comp = wm_cast(wm_composite, super);
     fprintf(file, "wm_composite (%f, %f - %f, %f)\n", comp->super.display_x, comp->super.display_y, comp->super.display_width, comp->super.display_height);
@@ -54,6 +54,8 @@ void wm_config_init_default(struct wm_config *config) {
     config->constrain_popups_to_toplevel = false;
 
     config->encourage_csd = true;
+    config->direct_scanout = false;
+    config->frame_timing = false;
     config->debug = false;
 }
 
@@ -98,7 +100,8 @@ void wm_config_set_xcursor_size(struct wm_config* config, int xcursor_size){
 
 void wm_config_add_output(struct wm_config *config, const char *name,
                           double scale, int width, int height, int mHz,
-                          int pos_x, int pos_y, enum wl_output_transform transform) {
+                          int pos_x, int pos_y, enum wl_output_transform transform,
+                          int max_render_time) {
     if(!name){
         wlr_log(WLR_ERROR, "Cannot add output config without name");
         return;
@@ -113,6 +116,7 @@ void wm_config_add_output(struct wm_config *config, const char *name,
     new->pos_x = pos_x;
     new->pos_y = pos_y;
     new->transform = transform;
+    new->max_render_time = max_render_time;
     wl_list_insert(&config->outputs, &new->link);
 }
 
@@ -9,12 +9,45 @@
 #include "wm/wm_output.h"
 #include "wm/wm_server.h"
 #include "wm/wm_layout.h"
+#include "wm/wm_spatial.h"
 #include "wm/wm_view.h"
 #include "wm/wm_view_xdg.h"
 #include "wm/wm_util.h"
 
 struct wm_content_vtable wm_content_base_vtable;
 
+/*
+ * Keep wm_server::wm_contents ordered by z_index (highest first) by moving
+ * content relative to its neighbours. Equal z_index keeps the current order,
+ * as the former (stable) bubble sort did.
+ */
+static void wm_content_reorder(struct wm_content* content){
+    struct wl_list* head = &content->wm_server->wm_contents;
+    struct wl_list* pos = content->link.prev;
+
+    /* Move towards the front past contents with lower z_index */
+    while(pos != head){
+        struct wm_content* prev = wl_container_of(pos, prev, link);
+        if(prev->z_index >= content->z_index) break;
+        pos = pos->prev;
+    }
+
+    if(pos == content->link.prev){
+        /* Move towards the back past contents with higher z_index */
+        pos = &content->link;
+        while(pos->next != head){
+            struct wm_content* next = wl_container_of(pos->next, next, link);
+            if(next->z_index <= content->z_index) break;
+            pos = pos->next;
+        }
+        if(pos == &content->link) return;
+    }
+
+    wl_list_remove(&content->link);
+    wl_list_insert(pos, &content->link);
+    content->wm_server->wm_contents_generation++;
+}
+
 void wm_content_init(struct wm_content* content, struct wm_server* server) {
     content->vtable = &wm_content_base_vtable;
 
@@ -33,13 +66,23 @@ void wm_content_init(struct wm_content* content, struct wm_server* server) {
 
 
     content->z_index = 0;
+    content->z_order = 0;
     wl_list_insert(&content->wm_server->wm_contents, &content->link);
+    wm_content_reorder(content);
+    content->wm_server->wm_contents_generation++;
+
+    content->spatial_unbounded = false;
+    content->spatial_x0 = 0;
+    content->spatial_y0 = 0;
+    content->spatial_x1 = -1;
+    content->spatial_y1 = -1;
 
     content->lock_enabled = false;
 }
 
 void wm_content_base_destroy(struct wm_content* content) {
     wl_list_remove(&content->link);
+    content->wm_server->wm_contents_generation++;
 }
 
 void wm_content_set_output(struct wm_content* content, int key, struct wlr_output* outp){
@@ -66,6 +109,10 @@ void wm_content_set_output(struct wm_content* content, int key, struct wlr_outpu
     content->fixed_output = res;
     wm_layout_damage_from(content->wm_server->wm_layout, content, NULL);
 
+    if(wm_content_is_view(content)){
+        wm_view_set_dirty(wm_cast(wm_view, content), WM_VIEW_DIRTY_OUTPUT);
+    }
+
     wm_layout_update_content_outputs(content->wm_server->wm_layout, content);
 }
 
@@ -79,6 +126,9 @@ struct wm_output* wm_content_get_output(struct wm_content* content){
 
     wlr_log(WLR_ERROR, "Removing invalid fixed output");
     content->fixed_output = NULL;
+    if(wm_content_is_view(content)){
+        wm_view_set_dirty(wm_cast(wm_view, content), WM_VIEW_DIRTY_OUTPUT);
+    }
     return NULL;
 }
 
@@ -95,6 +145,8 @@ void wm_content_set_workspace(struct wm_content* content, double x, double y, do
     content->workspace_height = height;
     wm_layout_damage_from(content->wm_server->wm_layout, content, NULL);
 
+    wm_spatial_update(content->wm_server->wm_spatial, content);
+
     wm_layout_update_content_outputs(content->wm_server->wm_layout, content);
 }
 
@@ -162,6 +214,7 @@ void wm_content_set_z_index(struct wm_content* content, double z_index){
     if(fabs(z_index - content->z_index) < 0.0001) return;
 
     content->z_index = z_index;
+    wm_content_reorder(content);
     wm_layout_damage_from(content->wm_server->wm_layout, content, NULL);
 
     /* Update scene node position if this is a view */
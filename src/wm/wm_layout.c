@@ -11,6 +11,7 @@
 #include "wm/wm_config.h"
 #include "wm/wm_util.h"
 #include "wm/wm_composite.h"
+#include "wm/wm_spatial.h"
 
 /*
  * Callbacks
@@ -40,6 +41,15 @@ static void handle_change(struct wl_listener* listener, void* data){
         }
     }
 
+    /* Output keys have changed */
+    struct wm_content* content;
+    wl_list_for_each(content, &layout->wm_server->wm_contents, link){
+        if(!wm_content_is_view(content)) continue;
+        wm_view_set_dirty(wm_cast(wm_view, content), WM_VIEW_DIRTY_OUTPUT);
+    }
+
+    wm_spatial_reconfigure(layout->wm_server->wm_spatial);
+
     wm_callback_layout_change(layout);
     wm_layout_damage_whole(layout);
 }
@@ -98,8 +108,10 @@ void wm_layout_damage_whole(struct wm_layout* layout){
     struct wm_output* output;
     wl_list_for_each(output, &layout->wm_outputs, link){
         DEBUG_PERFORMANCE(damage, output->key);
+        wm_output_frame_timing(output, WM_FRAME_TIMING_DAMAGE);
         wlr_damage_ring_add_whole(&output->damage_ring);
         wlr_output_schedule_frame(output->wlr_output);
+        wm_output_frame_timing(output, WM_FRAME_TIMING_SCHEDULE_FRAME);
 
         if(layout->refresh_master_output != layout->refresh_scheduled){
             layout->refresh_scheduled = output->key;
@@ -127,16 +139,20 @@ void wm_layout_damage_from(struct wm_layout* layout, struct wm_content* content,
 
 void wm_layout_damage_output(struct wm_layout* layout, struct wm_output* output, pixman_region32_t* damage, struct wm_content* from){
     if (wlr_damage_ring_add(&output->damage_ring, damage)) {
+        wm_output_frame_timing(output, WM_FRAME_TIMING_DAMAGE);
         wlr_output_schedule_frame(output->wlr_output);
+        wm_output_frame_timing(output, WM_FRAME_TIMING_SCHEDULE_FRAME);
     }
 
-    struct wm_content* content;
-    wl_list_for_each(content, &layout->wm_server->wm_contents, link){
-        if(!wm_content_is_composite(content)) continue;
-        struct wm_composite* comp = wm_cast(wm_composite, content);
-        if(comp->super.z_index > from->z_index && &comp->super != from){
-            wm_composite_on_damage_below(comp, output, from, damage);
-        }
+    struct wm_composite** composites;
+    int n_composites = wm_composite_list(layout->wm_server, &composites);
+    for(int i=0; i<n_composites; i++){
+        struct wm_composite* comp = composites[i];
+
+        /* Ordered by z-index - all remaining composites are below from */
+        if(comp->super.z_index <= from->z_index) break;
+
+        wm_composite_on_damage_below(comp, output, from, damage);
     }
 
     if(layout->refresh_master_output != layout->refresh_scheduled){
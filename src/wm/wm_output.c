@@ -7,13 +7,16 @@
 #include "wm/wm_server.h"
 #include "wm/wm_util.h"
 #include "wm/wm_view.h"
+#include "wm/wm_view_xdg.h"
 #include "wm/wm_widget.h"
 #include "wm/wm_seat.h"
 #include "wm/wm_cursor.h"
 #include "wm/wm_composite.h"
 #include <assert.h>
+#include <math.h>
 #include <time.h>
 #include <stdlib.h>
+#include <pthread.h>
 #include <wlr/util/log.h>
 #include <wlr/util/region.h>
 #include <wlr/types/wlr_matrix.h>
@@ -54,6 +57,10 @@ static void handle_commit(struct wl_listener *listener, void *data) {
         return;
     }
 
+    if(event->state->committed & WLR_OUTPUT_STATE_BUFFER){
+        wm_output_frame_timing(output, WM_FRAME_TIMING_COMMIT);
+    }
+
     if(event->state->committed & (WLR_OUTPUT_STATE_MODE |
             WLR_OUTPUT_STATE_TRANSFORM |
             WLR_OUTPUT_STATE_SCALE)){
@@ -67,39 +74,360 @@ static void handle_damage(struct wl_listener *listener, void *data) {
     struct wm_output *output = wl_container_of(listener, output, damage);
     struct wlr_output_event_damage* event = data;
     if (wlr_damage_ring_add(&output->damage_ring, event->damage)) {
+        wm_output_frame_timing(output, WM_FRAME_TIMING_DAMAGE);
         wlr_output_schedule_frame(output->wlr_output);
+        wm_output_frame_timing(output, WM_FRAME_TIMING_SCHEDULE_FRAME);
     }
 }
 
-static void handle_frame(struct wl_listener *listener, void *data) {
-    struct wm_output *output = wl_container_of(listener, output, frame);
+struct scanout_candidate {
+    struct wlr_scene_buffer* scene_buffer;
+    int n_buffers;
+    int sx;
+    int sy;
+};
+
+static void find_scanout_buffer(struct wlr_scene_buffer* scene_buffer, int sx, int sy, void* data){
+    struct scanout_candidate* candidate = data;
+    candidate->scene_buffer = scene_buffer;
+    candidate->sx = sx;
+    candidate->sy = sy;
+    candidate->n_buffers++;
+}
+
+/*
+ * Whether content shows anything on output. Unmapped views stay in
+ * wm_contents, xwayland views have no scene node and are not drawn, and
+ * opacity, mask or workspace can hide a content entirely
+ */
+static bool scanout_content_visible(struct wm_content* content, struct wm_output* output){
+    if(wm_content_get_opacity(content) <= 0.0) return false;
+    if(!wm_content_is_on_output(content, output)) return false;
+
+    if(wm_content_is_view(content)){
+        struct wm_view* view = wm_cast(wm_view, content);
+        if(!view->mapped || !wm_view_is_xdg(view)) return false;
+        struct wm_view_xdg* xdg_view = wm_cast(wm_view_xdg, view);
+        if(!xdg_view->scene_node || !xdg_view->scene_node->enabled) return false;
+    }
+
+    double display_x, display_y, display_w, display_h;
+    wm_content_get_box(content, &display_x, &display_y, &display_w, &display_h);
+    if(display_w <= 0.0 || display_h <= 0.0) return false;
+
+    double mask_x, mask_y, mask_w, mask_h;
+    wm_content_get_mask(content, &mask_x, &mask_y, &mask_w, &mask_h);
+    if(mask_w <= 0.0 || mask_h <= 0.0 || mask_x >= display_w || mask_y >= display_h ||
+            mask_x + mask_w <= 0.0 || mask_y + mask_h <= 0.0){
+        return false;
+    }
+
+    if(wm_content_has_workspace(content)){
+        double ws_x, ws_y, ws_w, ws_h;
+        wm_content_get_workspace(content, &ws_x, &ws_y, &ws_w, &ws_h);
+        if(ws_x >= display_x + display_w || ws_y >= display_y + display_h ||
+                ws_x + ws_w <= display_x || ws_y + ws_h <= display_y){
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * Client buffer to be put on the output directly instead of compositing, or
+ * NULL. Eligible is a single xdg view exactly covering the output, which is
+ * the topmost visible content there and to which no effect (opacity, corner
+ * radius, mask, workspace, lock) applies. Any widget or composite (blur)
+ * above it on the output falls back to composition. Xwayland views are not
+ * eligible, as they are not part of the scene
+ */
+static struct wlr_buffer* scanout_buffer(struct wm_output* output){
+    struct wm_server* server = output->wm_server;
+    if(!server->wm_config->direct_scanout || server->lock_perc != 0.0){
+        return NULL;
+    }
+    if(!wlr_output_is_direct_scanout_allowed(output->wlr_output)){
+        return NULL;
+    }
+
+    /* Sorted by z_index, highest first */
+    struct wm_content* top = NULL;
+    struct wm_content* content;
+    wl_list_for_each(content, &server->wm_contents, link){
+        if(!scanout_content_visible(content, output)) continue;
+
+        top = content;
+        break;
+    }
+    if(!top || !wm_content_is_view(top)) return NULL;
+
+    /* Visible views are mapped xdg views with a scene node */
+    struct wm_view_xdg* xdg_view = wm_cast(wm_view_xdg, wm_cast(wm_view, top));
+
+    if(wm_content_get_opacity(top) < 1.0 || wm_content_get_corner_radius(top) > 0.0){
+        return NULL;
+    }
+
+    int width, height;
+    wlr_output_effective_resolution(output->wlr_output, &width, &height);
+
+    double display_x, display_y, display_w, display_h;
+    wm_content_get_box(top, &display_x, &display_y, &display_w, &display_h);
+    if(fabs(display_x - output->layout_x) > 0.5 || fabs(display_y - output->layout_y) > 0.5 ||
+            fabs(display_w - width) > 0.5 || fabs(display_h - height) > 0.5){
+        return NULL;
+    }
 
+    double mask_x, mask_y, mask_w, mask_h;
+    wm_content_get_mask(top, &mask_x, &mask_y, &mask_w, &mask_h);
+    if(mask_x > 0.0 || mask_y > 0.0 || mask_x + mask_w < display_w || mask_y + mask_h < display_h){
+        return NULL;
+    }
+
+    if(wm_content_has_workspace(top)){
+        double ws_x, ws_y, ws_w, ws_h;
+        wm_content_get_workspace(top, &ws_x, &ws_y, &ws_w, &ws_h);
+        if(ws_x > display_x || ws_y > display_y || ws_x + ws_w < display_x + display_w || ws_y + ws_h < display_y + display_h){
+            return NULL;
+        }
+    }
+
+    /* No popups or subsurfaces, no viewport crop or scaling */
+    struct scanout_candidate candidate = { 0 };
+    wlr_scene_node_for_each_buffer(xdg_view->scene_node, find_scanout_buffer, &candidate);
+    if(candidate.n_buffers != 1 || candidate.sx != 0 || candidate.sy != 0){
+        return NULL;
+    }
+
+    struct wlr_scene_buffer* scene_buffer = candidate.scene_buffer;
+    if(!scene_buffer->buffer || scene_buffer->opacity < 1.0 ||
+            scene_buffer->transform != output->wlr_output->transform ||
+            !wlr_fbox_empty(&scene_buffer->src_box)){
+        return NULL;
+    }
+    if(scene_buffer->buffer->width != output->wlr_output->width ||
+            scene_buffer->buffer->height != output->wlr_output->height){
+        return NULL;
+    }
+
+    return scene_buffer->buffer;
+}
+
+/*
+ * Output state putting scanout_buffer on the output, false if there is none
+ * or the backend rejects it. Composition is left to
+ * wlr_scene_output_build_state, which also scans out on its own if the scene
+ * consists of a single buffer
+ */
+static bool build_scanout_state(struct wm_output* output, struct wlr_output_state* state){
+    struct wlr_buffer* buffer = scanout_buffer(output);
+    if(!buffer) return false;
+
+    wlr_output_state_set_buffer(state, buffer);
+    wlr_output_state_set_damage(state, &output->scene_output->damage_ring.current);
+    return wlr_output_test_state(output->wlr_output, state);
+}
+
+static void render(struct wm_output* output){
     if(!output->wlr_output->enabled){
         return;
     }
 
+    TIMER_START(render);
+    wm_output_frame_timing(output, WM_FRAME_TIMING_RENDER_BEGIN);
+
     struct timespec now;
     clock_gettime(CLOCK_MONOTONIC, &now);
 
     /* Ensure z-index */
     wm_server_update_contents(output->wm_server);
 
-    /* Render the scene if needed and commit the output */
-    wlr_scene_output_commit(output->scene_output, NULL);
+    /* Render the scene if needed and commit the output, bypassing composition if possible */
+    bool needs_frame = output->wlr_output->needs_frame ||
+        pixman_region32_not_empty(&output->scene_output->damage_ring.current);
+    if(needs_frame){
+        struct wlr_output_state state;
+        wlr_output_state_init(&state);
+
+        bool built = build_scanout_state(output, &state);
+        if(built){
+            if(!output->scanout){
+                wlr_log(WLR_DEBUG, "Output %s: Direct scanout", output->wlr_output->name);
+            }
+            output->scanout = true;
+        }else{
+            if(output->scanout){
+                wlr_log(WLR_DEBUG, "Output %s: Composition", output->wlr_output->name);
+
+                /* The scene's buffers do not know what has been shown in the meantime */
+                wlr_damage_ring_add_whole(&output->scene_output->damage_ring);
+                output->scanout = false;
+            }
+
+            wlr_output_state_finish(&state);
+            wlr_output_state_init(&state);
+            built = wlr_scene_output_build_state(output->scene_output, &state, NULL);
+        }
+
+        if(built && wlr_output_commit_state(output->wlr_output, &state)){
+            /* The damage has been presented */
+            wlr_damage_ring_rotate(&output->scene_output->damage_ring);
+        }
+        wlr_output_state_finish(&state);
+    }
+
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    output->render_times[output->render_times_pos] =
+        (end.tv_sec - now.tv_sec) * 1000000L + (end.tv_nsec - now.tv_nsec) / 1000L;
+    output->render_times_pos = (output->render_times_pos + 1) % WM_OUTPUT_RENDER_TIMES;
+
+    /* All outputs together, see dev/benchmark_outputs.py */
+    TIMER_STOP(render);
+    TIMER_PRINT(render);
 
     /* Send frame done events */
     wlr_scene_output_for_each_buffer(output->scene_output, send_frame_done, &now);
 
     /* 
-     * Synchronous update is best scheduled immediately after frame
+     * Synchronous update is best scheduled immediately after frame - i.e.
+     * right after the render deadline, if set
      */
     DEBUG_PERFORMANCE(present_frame, output->key);
     wm_server_schedule_update(output->wm_server, output);
+
+    wm_output_frame_timing(output, WM_FRAME_TIMING_RENDER_END);
+}
+
+static int render_timer_handler(void* data){
+    struct wm_output* output = data;
+    render(output);
+    return 0;
+}
+
+/* Unit: ms, time to wait after the frame event until the render deadline */
+static long render_delay(struct wm_output* output){
+    if(output->max_render_time == 0 || output->refresh_nsec <= 0 || output->last_presentation.tv_sec == 0){
+        return 0;
+    }
+
+    long budget;
+    if(output->max_render_time > 0){
+        budget = output->max_render_time * 1000L;
+    }else{
+        budget = 0;
+        for(int i=0; i<WM_OUTPUT_RENDER_TIMES; i++){
+            if(output->render_times[i] > budget) budget = output->render_times[i];
+        }
+        budget += WM_OUTPUT_RENDER_MARGIN;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long since_presentation =
+        (now.tv_sec - output->last_presentation.tv_sec) * 1000000L +
+        (now.tv_nsec - output->last_presentation.tv_nsec) / 1000L;
+
+    /* Missed vblanks do not matter, only the phase */
+    long until_vblank = output->refresh_nsec / 1000L - since_presentation % (output->refresh_nsec / 1000L);
+
+    long delay = (until_vblank - budget) / 1000L;
+    return delay < 1 ? 0 : delay;
+}
+
+static void handle_frame(struct wl_listener *listener, void *data) {
+    struct wm_output *output = wl_container_of(listener, output, frame);
+
+    if(!output->wlr_output->enabled){
+        return;
+    }
+
+    /* Delay rendering to let late client commits make it into the frame */
+    long delay = render_delay(output);
+    if(delay > 0){
+        wl_event_source_timer_update(output->render_timer, delay);
+    }else{
+        render(output);
+    }
+}
+
+static void publish_frame_timing(struct wm_output* output, struct wm_frame_timing* frame){
+    struct wm_server* server = output->wm_server;
+    struct wm_frame_timings* timings = output->frame_timings;
+
+    pthread_mutex_lock(&server->frame_timings_mutex);
+    timings->output_key = output->key;
+    frame->seq = timings->n;
+    timings->frames[timings->n % WM_OUTPUT_FRAME_TIMINGS] = *frame;
+    timings->n++;
+    pthread_mutex_unlock(&server->frame_timings_mutex);
+
+    *frame = (struct wm_frame_timing){ 0 };
+}
+
+static void handle_present(struct wl_listener *listener, void *data) {
+    struct wm_output *output = wl_container_of(listener, output, present);
+    struct wlr_output_event_present* event = data;
+
+    if(!event->presented || !event->when){
+        return;
+    }
+
+    output->last_presentation = *event->when;
+
+    /* Belongs to the last committed frame */
+    struct wm_frame_timing* frame = &output->frame_timing_presenting;
+    if(output->wm_server->wm_config->frame_timing && frame->t[WM_FRAME_TIMING_COMMIT]){
+        frame->t[WM_FRAME_TIMING_PRESENT] = event->when->tv_sec * 1000000000LL + event->when->tv_nsec;
+        publish_frame_timing(output, frame);
+    }
+    output->refresh_nsec = event->refresh;
+    if(output->refresh_nsec <= 0 && output->wlr_output->refresh > 0){
+        output->refresh_nsec = 1000000000000L / output->wlr_output->refresh;
+    }
 }
 
 static void handle_needs_frame(struct wl_listener *listener, void *data) {
     struct wm_output *output = wl_container_of(listener, output, needs_frame);
     wlr_output_schedule_frame(output->wlr_output);
+    wm_output_frame_timing(output, WM_FRAME_TIMING_SCHEDULE_FRAME);
+}
+
+void wm_output_frame_timing(struct wm_output* output, enum wm_frame_timing_event event){
+    if(!output->wm_server->wm_config->frame_timing) return;
+
+    struct wm_frame_timing* frame = &output->frame_timing;
+
+    /* For the "first ... since last frame" events, keep the earliest */
+    if(frame->t[event] && (event == WM_FRAME_TIMING_DAMAGE ||
+                event == WM_FRAME_TIMING_SCHEDULE_FRAME ||
+                event == WM_FRAME_TIMING_PY_START)){
+        return;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    frame->t[event] = now.tv_sec * 1000000000LL + now.tv_nsec;
+
+    /* A frame is complete once render is done - if nothing has been committed, keep collecting */
+    if(event == WM_FRAME_TIMING_RENDER_END && frame->t[WM_FRAME_TIMING_COMMIT]){
+        /* The last frame has not been presented */
+        if(output->frame_timing_presenting.t[WM_FRAME_TIMING_COMMIT]){
+            publish_frame_timing(output, &output->frame_timing_presenting);
+        }
+
+        output->frame_timing_presenting = *frame;
+        *frame = (struct wm_frame_timing){ 0 };
+    }
+}
+
+int wm_frame_timings_copy(struct wm_frame_timings* timings, struct wm_frame_timing* dest){
+    uint64_t first = timings->n > WM_OUTPUT_FRAME_TIMINGS ? timings->n - WM_OUTPUT_FRAME_TIMINGS : 0;
+    for(uint64_t i=first; i<timings->n; i++){
+        dest[i - first] = timings->frames[i % WM_OUTPUT_FRAME_TIMINGS];
+    }
+    return timings->n - first;
 }
 
 /*
@@ -183,6 +511,11 @@ static double configure(struct wm_output* output){
     wlr_log(WLR_INFO, "Output: Setting scale to %f", scale);
     wlr_output_set_scale(output->wlr_output, scale);
 
+    output->max_render_time = config ? config->max_render_time : 0;
+    if(output->max_render_time){
+        wlr_log(WLR_INFO, "Output: Setting max render time to %dms", output->max_render_time);
+    }
+
     return scale;
 }
 
@@ -201,6 +534,13 @@ void wm_output_init(struct wm_output *output, struct wm_server *server, struct w
     output->layout_x = 0;
     output->layout_y = 0;
 
+    output->max_render_time = 0;
+    output->render_timer = wl_event_loop_add_timer(server->wl_event_loop, render_timer_handler, output);
+    output->last_presentation = (struct timespec){ 0 };
+    output->refresh_nsec = 0;
+    for(int i=0; i<WM_OUTPUT_RENDER_TIMES; i++) output->render_times[i] = 0;
+    output->render_times_pos = 0;
+
     if (!wm_renderer_init_output(server->wm_renderer, output)) {
         wlr_log(WLR_ERROR, "Failed to init output render");
         return;
@@ -228,6 +568,9 @@ void wm_output_init(struct wm_output *output, struct wm_server *server, struct w
     output->needs_frame.notify = &handle_needs_frame;
     wl_signal_add(&wlr_output->events.needs_frame, &output->needs_frame);
 
+    output->present.notify = &handle_present;
+    wl_signal_add(&wlr_output->events.present, &output->present);
+
     /* Let the cursor know we possibly have a new scale */
     wm_cursor_ensure_loaded_for_scale(server->wm_seat->wm_cursor, scale);
 
@@ -236,6 +579,15 @@ void wm_output_init(struct wm_output *output, struct wm_server *server, struct w
 #endif
 
     output->expecting_frame = false;
+    output->scanout = false;
+
+    output->frame_timing = (struct wm_frame_timing){ 0 };
+    output->frame_timing_presenting = (struct wm_frame_timing){ 0 };
+    output->frame_timings = calloc(1, sizeof(struct wm_frame_timings));
+    output->frame_timings->output_key = output->key;
+    pthread_mutex_lock(&server->frame_timings_mutex);
+    wl_list_insert(&server->frame_timings, &output->frame_timings->link);
+    pthread_mutex_unlock(&server->frame_timings_mutex);
     clock_gettime(CLOCK_MONOTONIC, &output->last_frame);
 
     wlr_output_schedule_frame(wlr_output);
@@ -244,6 +596,12 @@ void wm_output_init(struct wm_output *output, struct wm_server *server, struct w
 void wm_output_reconfigure(struct wm_output* output){
     double scale = configure(output);
     wm_cursor_ensure_loaded_for_scale(output->wm_server->wm_seat->wm_cursor, scale);
+
+    /* Do not publish a partly recorded frame once reenabled */
+    if(!output->wm_server->wm_config->frame_timing){
+        output->frame_timing = (struct wm_frame_timing){ 0 };
+        output->frame_timing_presenting = (struct wm_frame_timing){ 0 };
+    }
 }
 
 void wm_output_destroy(struct wm_output *output) {
@@ -252,6 +610,9 @@ void wm_output_destroy(struct wm_output *output) {
     wl_list_remove(&output->damage.link);
     wl_list_remove(&output->frame.link);
     wl_list_remove(&output->needs_frame.link);
+    wl_list_remove(&output->present.link);
+
+    wl_event_source_remove(output->render_timer);
 
     /* Destroy scene output */
     if (output->scene_output) {
@@ -263,5 +624,10 @@ void wm_output_destroy(struct wm_output *output) {
     wm_renderer_buffers_destroy(output->renderer_buffers);
 #endif
 
+    pthread_mutex_lock(&output->wm_server->frame_timings_mutex);
+    wl_list_remove(&output->frame_timings->link);
+    pthread_mutex_unlock(&output->wm_server->frame_timings_mutex);
+    free(output->frame_timings);
+
     free(output);
 }
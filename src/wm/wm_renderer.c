@@ -2,6 +2,7 @@
 
 #include <assert.h>
 #include <math.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <wayland-server.h>
@@ -13,11 +14,13 @@
 #include "wm/wm_renderer.h"
 #include "wm/wm_server.h"
 #include "wm/wm_config.h"
+#include "wm/wm_util.h"
 
 #ifdef WM_CUSTOM_RENDERER
 
 #include <wlr/render/gles2.h>
 #include "wm/shaders/wm_shaders.h"
+#include "wm/wm_shader_cache.h"
 
 #include "quad_shaders.c"
 
@@ -66,13 +69,30 @@ static GLuint compile_shader(struct wlr_gles2_renderer *renderer, GLuint type,
     return shader;
 }
 
+static double msec_since(struct timespec start){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start.tv_sec) * 1000. + (now.tv_nsec - start.tv_nsec) / 1000000.;
+}
+
 static GLuint wm_renderer_link_program(struct wm_renderer *renderer,
+                                const char *name,
                                 const GLchar *vert_src,
                                 const GLchar *frag_src) {
     struct wlr_gles2_renderer *gles2_renderer =
         gles2_get_renderer(renderer->wlr_renderer);
     push_gles2_debug(gles2_renderer);
 
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    GLuint prog = wm_shader_cache_load(&renderer->shader_cache, vert_src, frag_src);
+    if (prog) {
+        wlr_log(WLR_DEBUG, "Loaded program %s from cache in %.2fms", name, msec_since(start));
+        pop_gles2_debug(gles2_renderer);
+        return prog;
+    }
+
     GLuint vert = compile_shader(gles2_renderer, GL_VERTEX_SHADER,
                                  vert_src);
     if (!vert) {
@@ -86,7 +106,8 @@ static GLuint wm_renderer_link_program(struct wm_renderer *renderer,
         goto error;
     }
 
-    GLuint prog = glCreateProgram();
+    prog = glCreateProgram();
+    glProgramParameteri(prog, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glAttachShader(prog, vert);
     glAttachShader(prog, frag);
     glLinkProgram(prog);
@@ -103,17 +124,21 @@ static GLuint wm_renderer_link_program(struct wm_renderer *renderer,
         goto error;
     }
 
+    wlr_log(WLR_DEBUG, "Compiled program %s in %.2fms", name, msec_since(start));
+    wm_shader_cache_store(&renderer->shader_cache, prog, vert_src, frag_src);
+
     pop_gles2_debug(gles2_renderer);
     return prog;
 
 error:
+    wlr_log(WLR_ERROR, "Could not compile program %s", name);
     return 0;
 }
 
 static void wm_renderer_init_quad_shaders(struct wm_renderer* renderer){
     wlr_log(WLR_DEBUG, "Setting up quad shaders");
     /* Quad shader */
-    renderer->quad_shader.shader = wm_renderer_link_program(renderer, quad_vertex_src, quad_fragment_src);
+    renderer->quad_shader.shader = wm_renderer_link_program(renderer, "quad", quad_vertex_src, quad_fragment_src);
     assert(renderer->quad_shader.shader);
 
     renderer->quad_shader.tex = glGetUniformLocation(renderer->quad_shader.shader, "tex");
@@ -121,7 +146,7 @@ static void wm_renderer_init_quad_shaders(struct wm_renderer* renderer){
     renderer->quad_shader.tex_attrib = glGetAttribLocation(renderer->quad_shader.shader, "texcoord");
 
     /* Downsample shader */
-    renderer->downsample_shader.shader = wm_renderer_link_program(renderer, quad_vertex_src, quad_fragment_downsample_src);
+    renderer->downsample_shader.shader = wm_renderer_link_program(renderer, "downsample", quad_vertex_src, quad_fragment_downsample_src);
     assert(renderer->downsample_shader.shader);
 
     renderer->downsample_shader.tex = glGetUniformLocation(renderer->downsample_shader.shader, "tex");
@@ -132,7 +157,7 @@ static void wm_renderer_init_quad_shaders(struct wm_renderer* renderer){
     renderer->downsample_shader.offset = glGetUniformLocation(renderer->downsample_shader.shader, "offset");
 
     /* Upsample shader */
-    renderer->upsample_shader.shader = wm_renderer_link_program(renderer, quad_vertex_src, quad_fragment_upsample_src);
+    renderer->upsample_shader.shader = wm_renderer_link_program(renderer, "upsample", quad_vertex_src, quad_fragment_upsample_src);
     assert(renderer->upsample_shader.shader);
 
     renderer->upsample_shader.tex = glGetUniformLocation(renderer->upsample_shader.shader, "tex");
@@ -153,9 +178,10 @@ static void wm_renderer_init_quad_shaders(struct wm_renderer* renderer){
 
 static void wm_renderer_link_texture_shader(struct wm_renderer *renderer,
                                      struct wm_renderer_texture_shader *shader,
+                                     const char *name,
                                      const GLchar *vert_src,
                                      const GLchar *frag_src) {
-    shader->shader = wm_renderer_link_program(renderer, vert_src, frag_src);
+    shader->shader = wm_renderer_link_program(renderer, name, vert_src, frag_src);
     assert(shader->shader);
 
     shader->proj = glGetUniformLocation(shader->shader, "proj");
@@ -188,9 +214,6 @@ void wm_renderer_add_texture_shaders(
     const GLchar *frag_src_rgba, const GLchar *frag_src_rgbx,
     const GLchar *frag_src_ext) {
 
-    struct wlr_gles2_renderer *gles2_renderer =
-        gles2_get_renderer(renderer->wlr_renderer);
-
     int i = 0;
     for (; i < renderer->n_texture_shaders; i++) {
         if (!renderer->texture_shaders[i].name)
@@ -198,19 +221,13 @@ void wm_renderer_add_texture_shaders(
     }
     assert(i < renderer->n_texture_shaders);
 
+    /* Linked on first selection */
     renderer->texture_shaders[i].name = strdup(name);
-
-    wm_renderer_link_texture_shader(
-        renderer, &renderer->texture_shaders[i].rgba, vert_src, frag_src_rgba);
-
-    wm_renderer_link_texture_shader(
-        renderer, &renderer->texture_shaders[i].rgbx, vert_src, frag_src_rgbx);
-
-    if (gles2_renderer->exts.OES_egl_image_external) {
-        wm_renderer_link_texture_shader(renderer,
-                                        &renderer->texture_shaders[i].ext,
-                                        vert_src, frag_src_ext);
-    }
+    renderer->texture_shaders[i].linked = false;
+    renderer->texture_shaders[i].vert_src = vert_src;
+    renderer->texture_shaders[i].frag_src_rgba = frag_src_rgba;
+    renderer->texture_shaders[i].frag_src_rgbx = frag_src_rgbx;
+    renderer->texture_shaders[i].frag_src_ext = frag_src_ext;
 }
 
 void wm_renderer_init_primitive_shaders(struct wm_renderer* renderer, int n_shaders){
@@ -231,27 +248,76 @@ void wm_renderer_add_primitive_shader(struct wm_renderer *renderer,
 
     wlr_log(WLR_DEBUG, "Adding shader %s at %d", name, i);
 
+    /* Linked on first selection */
     renderer->primitive_shaders[i].name = strdup(name);
     renderer->primitive_shaders[i].n_params_float = n_params_float;
     renderer->primitive_shaders[i].n_params_int = n_params_int;
+    renderer->primitive_shaders[i].linked = false;
+    renderer->primitive_shaders[i].vert_src = vert_src;
+    renderer->primitive_shaders[i].frag_src = frag_src;
+}
 
-    renderer->primitive_shaders[i].shader = wm_renderer_link_program(renderer, vert_src, frag_src);
-    assert(renderer->primitive_shaders[i].shader);
+/*
+ * Selection may happen outside of rendering (e.g. upon reconfigure), so make
+ * the context current if necessary
+ */
+static bool ensure_current(struct wm_renderer* renderer){
+    struct wlr_gles2_renderer *gles2_renderer = gles2_get_renderer(renderer->wlr_renderer);
+    if(wlr_egl_is_current(gles2_renderer->egl)) return false;
 
-    renderer->primitive_shaders[i].proj = glGetUniformLocation(renderer->primitive_shaders[i].shader, "proj");
-    renderer->primitive_shaders[i].alpha = glGetUniformLocation(renderer->primitive_shaders[i].shader, "alpha");
-    renderer->primitive_shaders[i].width = glGetUniformLocation(renderer->primitive_shaders[i].shader, "width");
-    renderer->primitive_shaders[i].height = glGetUniformLocation(renderer->primitive_shaders[i].shader, "height");
-    renderer->primitive_shaders[i].pos_attrib = glGetAttribLocation(renderer->primitive_shaders[i].shader, "pos");
-    renderer->primitive_shaders[i].tex_attrib = glGetAttribLocation(renderer->primitive_shaders[i].shader, "texcoord");
+    assert(wlr_egl_make_current(gles2_renderer->egl));
+    return true;
+}
 
-    if(n_params_float){
-        renderer->primitive_shaders[i].params_float = glGetUniformLocation(renderer->primitive_shaders[i].shader, "params_float");
-    }
-    if(n_params_int){
-        renderer->primitive_shaders[i].params_int = glGetUniformLocation(renderer->primitive_shaders[i].shader, "params_int");
+static void restore_current(struct wm_renderer* renderer, bool made_current){
+    if(!made_current) return;
+
+    struct wlr_gles2_renderer *gles2_renderer = gles2_get_renderer(renderer->wlr_renderer);
+    wlr_egl_unset_current(gles2_renderer->egl);
+}
+
+static void wm_renderer_ensure_texture_shaders(struct wm_renderer* renderer, struct wm_renderer_texture_shaders* shaders){
+    if(shaders->linked) return;
+
+    struct wlr_gles2_renderer *gles2_renderer =
+        gles2_get_renderer(renderer->wlr_renderer);
+    bool made_current = ensure_current(renderer);
+
+    char name[64];
+    snprintf(name, sizeof(name), "%s/rgba", shaders->name);
+    wm_renderer_link_texture_shader(renderer, &shaders->rgba, name, shaders->vert_src, shaders->frag_src_rgba);
+
+    snprintf(name, sizeof(name), "%s/rgbx", shaders->name);
+    wm_renderer_link_texture_shader(renderer, &shaders->rgbx, name, shaders->vert_src, shaders->frag_src_rgbx);
+
+    if (gles2_renderer->exts.OES_egl_image_external) {
+        snprintf(name, sizeof(name), "%s/ext", shaders->name);
+        wm_renderer_link_texture_shader(renderer, &shaders->ext, name, shaders->vert_src, shaders->frag_src_ext);
     }
 
+    restore_current(renderer, made_current);
+    shaders->linked = true;
+}
+
+static void wm_renderer_ensure_primitive_shader(struct wm_renderer* renderer, struct wm_renderer_primitive_shader* shader){
+    if(shader->linked) return;
+
+    bool made_current = ensure_current(renderer);
+
+    shader->shader = wm_renderer_link_program(renderer, shader->name, shader->vert_src, shader->frag_src);
+    assert(shader->shader);
+
+    shader->proj = glGetUniformLocation(shader->shader, "proj");
+    shader->pos_attrib = glGetAttribLocation(shader->shader, "pos");
+    shader->tex_attrib = glGetAttribLocation(shader->shader, "texcoord");
+    shader->alpha = glGetUniformLocation(shader->shader, "alpha");
+    shader->width = glGetUniformLocation(shader->shader, "width");
+    shader->height = glGetUniformLocation(shader->shader, "height");
+    shader->params_float = glGetUniformLocation(shader->shader, "params_float");
+    shader->params_int = glGetUniformLocation(shader->shader, "params_int");
+
+    restore_current(renderer, made_current);
+    shader->linked = true;
 }
 
 #endif
@@ -271,36 +337,45 @@ void wm_renderer_select_texture_shaders(struct wm_renderer *renderer,
         wlr_log(WLR_INFO, "Could not find texture shaders '%s' - defaulting", name);
         renderer->texture_shaders_selected = renderer->texture_shaders;
     }
+    wm_renderer_ensure_texture_shaders(renderer, renderer->texture_shaders_selected);
 #endif
 }
 
-void wm_renderer_select_primitive_shader(struct wm_renderer *renderer,
-                                         const char *name) {
+int wm_renderer_get_primitive_shader(struct wm_renderer *renderer,
+                                     const char *name) {
 #ifdef WM_CUSTOM_RENDERER
-    int i = 0;
-    for (; i < renderer->n_primitive_shaders; i++) {
+    for (int i = 0; i < renderer->n_primitive_shaders; i++) {
         if (renderer->primitive_shaders[i].name && !strcmp(renderer->primitive_shaders[i].name, name))
-            break;
-    }
-    if (i < renderer->n_primitive_shaders){
-        renderer->primitive_shader_selected = renderer->primitive_shaders + i;
-    }else{
-        wlr_log(WLR_INFO, "Could not find primitive shader '%s' - defaulting", name);
-        renderer->primitive_shader_selected = renderer->primitive_shaders;
+            return i;
     }
+
+    wlr_log(WLR_INFO, "Could not find primitive shader '%s' - defaulting", name);
+    return renderer->n_primitive_shaders > 0 ? 0 : -1;
+#else
+    return -1;
 #endif
 }
 
-bool wm_renderer_check_primitive_params(struct wm_renderer* renderer, int n_int, int n_float){
+void wm_renderer_select_primitive_shader(struct wm_renderer *renderer,
+                                         int shader) {
 #ifdef WM_CUSTOM_RENDERER
-    if(!renderer->primitive_shader_selected) return false;
+    assert(shader >= 0 && shader < renderer->n_primitive_shaders);
+    renderer->primitive_shader_selected = renderer->primitive_shaders + shader;
+    wm_renderer_ensure_primitive_shader(renderer, renderer->primitive_shader_selected);
+#endif
+}
+
+bool wm_renderer_check_primitive_params(struct wm_renderer* renderer, int shader, int n_int, int n_float){
+#ifdef WM_CUSTOM_RENDERER
+    if(shader < 0 || shader >= renderer->n_primitive_shaders) return false;
+    struct wm_renderer_primitive_shader* s = renderer->primitive_shaders + shader;
 
-    if(n_int < renderer->primitive_shader_selected->n_params_int){
-        wlr_log(WLR_ERROR, "Not enough int parameters (%d) for shader %s (%d)", n_int, renderer->primitive_shader_selected->name, renderer->primitive_shader_selected->n_params_int);
+    if(n_int < s->n_params_int){
+        wlr_log(WLR_ERROR, "Not enough int parameters (%d) for shader %s (%d)", n_int, s->name, s->n_params_int);
         return false;
     }
-    if(n_float < renderer->primitive_shader_selected->n_params_float){
-        wlr_log(WLR_ERROR, "Not enough float parameters (%d) for shader %s (%d)", n_float, renderer->primitive_shader_selected->name, renderer->primitive_shader_selected->n_params_float);
+    if(n_float < s->n_params_float){
+        wlr_log(WLR_ERROR, "Not enough float parameters (%d) for shader %s (%d)", n_float, s->name, s->n_params_float);
         return false;
     }
 #endif
@@ -483,13 +558,24 @@ void wm_renderer_init(struct wm_renderer *renderer, struct wm_server *server) {
 
         struct wlr_gles2_renderer *gles2_renderer = gles2_get_renderer(renderer->wlr_renderer);
         assert(wlr_egl_make_current(gles2_renderer->egl));
+
+        struct timespec shaders_start, shaders_end;
+        clock_gettime(CLOCK_MONOTONIC, &shaders_start);
+
+        wm_shader_cache_init(&renderer->shader_cache);
         wm_texture_shaders_init(renderer);
         wm_primitive_shaders_init(renderer);
         wm_renderer_init_quad_shaders(renderer);
         renderer->selected_buffer = 0;
 
+        clock_gettime(CLOCK_MONOTONIC, &shaders_end);
+        wlr_log(WLR_INFO, "Set up shaders in %ldms (cache: %d hits, %d misses)",
+                msec_diff(shaders_end, shaders_start),
+                renderer->shader_cache.n_hits, renderer->shader_cache.n_misses);
+
         wm_renderer_select_texture_shaders(renderer, server->wm_config->texture_shaders);
         renderer->primitive_shader_selected = renderer->primitive_shaders;
+        wm_renderer_ensure_primitive_shader(renderer, renderer->primitive_shader_selected);
 
         wlr_egl_unset_current(gles2_renderer->egl);
     }else{
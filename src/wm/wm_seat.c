@@ -199,6 +199,7 @@ void wm_seat_focus_surface(struct wm_seat* seat, struct wlr_surface* surface){
     wl_list_for_each(content, &seat->wm_server->wm_contents, link){
         if(!wm_content_is_view(content)) continue;
         struct wm_view* view = wm_cast(wm_view, content);
+        if(view->focused) wm_view_set_dirty(view, WM_VIEW_DIRTY_STATE);
         view->focused = false;
     }
 
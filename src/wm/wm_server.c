@@ -38,6 +38,7 @@
 #include "wm/wm_view_xwayland.h"
 #endif
 #include "wm/wm_layout.h"
+#include "wm/wm_spatial.h"
 #include "wm/wm_widget.h"
 #include "wm/wm_config.h"
 #include "wm/wm_output.h"
@@ -195,6 +196,13 @@ static void handle_ready(struct wl_listener* listener, void* data){
 }
 #endif
 
+static void frame_timing_all(struct wm_server* server, enum wm_frame_timing_event event){
+    struct wm_output* output;
+    wl_list_for_each(output, &server->wm_layout->wm_outputs, link){
+        wm_output_frame_timing(output, event);
+    }
+}
+
 static int callback_timer_handler(void* data){
     struct wm_server* server = data;
 
@@ -203,11 +211,13 @@ static int callback_timer_handler(void* data){
         server->constant_damage_mode = 1;
     }else{
         DEBUG_PERFORMANCE(py_start, 0);
+        frame_timing_all(server, WM_FRAME_TIMING_PY_START);
         wm_layout_start_update(server->wm_layout);
         wm_callback_update();
         if(server->constant_damage_mode == 1 && wm_layout_get_refresh_output(server->wm_layout) < 0){
             wm_layout_damage_whole(server->wm_layout);
         }
+        frame_timing_all(server, WM_FRAME_TIMING_PY_FINISH);
         DEBUG_PERFORMANCE(py_finish, 0);
     }
 
@@ -233,6 +243,14 @@ void wm_server_set_constant_damage_mode(struct wm_server* server, int mode){
  */
 void wm_server_init(struct wm_server* server, struct wm_config* config){
     wl_list_init(&server->wm_contents);
+    server->wm_contents_generation = 0;
+    server->wm_contents_sorted_generation = 0;
+    server->wm_composites = NULL;
+    server->n_composites = 0;
+    server->size_composites = 0;
+    wl_list_init(&server->frame_timings);
+    pthread_mutex_init(&server->frame_timings_mutex, NULL);
+    server->wm_composites_generation = 0;
     server->wm_config = config;
 
     /* Display */
@@ -300,6 +318,9 @@ void wm_server_init(struct wm_server* server, struct wm_config* config){
     server->wm_layout = calloc(1, sizeof(struct wm_layout));
     wm_layout_init(server->wm_layout, server);
 
+    server->wm_spatial = calloc(1, sizeof(struct wm_spatial));
+    wm_spatial_init(server->wm_spatial, server);
+
     /* Create scene graph */
     server->wlr_scene = wlr_scene_create();
     wlr_scene_attach_output_layout(server->wlr_scene, server->wm_layout->wlr_output_layout);
@@ -374,104 +395,108 @@ void wm_server_init(struct wm_server* server, struct wm_config* config){
     server->constant_damage_mode = 0;
 }
 
+void wm_server_frame_timings_foreach(struct wm_server* server, void (*f)(struct wm_frame_timings* timings, void* data), void* data){
+    pthread_mutex_lock(&server->frame_timings_mutex);
+    struct wm_frame_timings* timings;
+    wl_list_for_each(timings, &server->frame_timings, link){
+        f(timings, data);
+    }
+    pthread_mutex_unlock(&server->frame_timings_mutex);
+}
+
 void wm_server_destroy(struct wm_server* server){
     wm_renderer_destroy(server->wm_renderer);
     wm_layout_destroy(server->wm_layout);
     wm_seat_destroy(server->wm_seat);
     wm_idle_inhibit_destroy(server->wm_idle_inhibit);
+    wm_spatial_destroy(server->wm_spatial);
     wm_config_destroy(server->wm_config);
 
     free(server->wm_renderer);
     free(server->wm_layout);
     free(server->wm_seat);
     free(server->wm_idle_inhibit);
+    free(server->wm_spatial);
+    free(server->wm_composites);
 
 #ifdef WM_HAS_XWAYLAND
     wlr_xwayland_destroy(server->wlr_xwayland);
 #endif
     wl_display_destroy_clients(server->wl_display);
     wl_display_destroy(server->wl_display);
+
+    /* Outputs are gone */
+    pthread_mutex_destroy(&server->frame_timings_mutex);
 }
 
-void wm_server_surface_at(struct wm_server* server, double at_x, double at_y, 
-        struct wlr_surface** result, double* result_sx, double* result_sy, double* result_scale_x, double* result_scale_y){
-    struct wm_content* content;
-    wl_list_for_each(content, &server->wm_contents, link){
-        if(!wm_content_is_view(content)) continue;
-        struct wm_view* view = wm_cast(wm_view, content);
+/* Surface of view at at_x, at_y (layout coordinates), NULL if it does not accept input there */
+static struct wlr_surface* view_surface_at(struct wm_view* view, double at_x, double at_y,
+        double* result_sx, double* result_sy, double* result_scale_x, double* result_scale_y){
+    if(!view->mapped) return NULL;
+    if(!view->accepts_input) return NULL;
+
+    if(wm_content_has_workspace(&view->super)){
+        double x, y, w, h;
+        wm_content_get_workspace(&view->super, &x, &y, &w, &h);
+        if(at_x < x) return NULL;
+        if(at_y < y) return NULL;
+        if(at_x > x+w) return NULL;
+        if(at_y > y+h) return NULL;
+    }
 
-        if(!view->mapped) continue;
-        if(!view->accepts_input) continue;
+    int width;
+    int height;
+    wm_view_get_size(view, &width, &height);
 
-        if(wm_content_has_workspace(&view->super)){
-            double x, y, w, h;
-            wm_content_get_workspace(&view->super, &x, &y, &w, &h);
-            if(at_x < x) continue;
-            if(at_y < y) continue;
-            if(at_x > x+w) continue;
-            if(at_y > y+h) continue;
-        }
+    if(width <= 0 || height <=0) return NULL;
+
+    double display_x, display_y, display_width, display_height;
+    wm_content_get_box(&view->super, &display_x, &display_y, &display_width, &display_height);
 
-        int width;
-        int height;
-        wm_view_get_size(view, &width, &height);
+    double scale_x = display_width/width;
+    double scale_y = display_height/height;
 
-        if(width <= 0 || height <=0) continue;
+    int view_at_x = round((at_x - display_x) / scale_x);
+    int view_at_y = round((at_y - display_y) / scale_y);
 
-        double display_x, display_y, display_width, display_height;
-        wm_content_get_box(content, &display_x, &display_y, &display_width, &display_height);
+    double sx;
+    double sy;
+    struct wlr_surface* surface = wm_view_surface_at(view, view_at_x, view_at_y, &sx, &sy);
 
-        double scale_x = display_width/width;
-        double scale_y = display_height/height;
+    if(surface){
+        if(result_sx) *result_sx = sx;
+        if(result_sy) *result_sy = sy;
+        if(result_scale_x) *result_scale_x = scale_x;
+        if(result_scale_y) *result_scale_y = scale_y;
+    }
+    return surface;
+}
 
-        int view_at_x = round((at_x - display_x) / scale_x);
-        int view_at_y = round((at_y - display_y) / scale_y);
+void wm_server_surface_at(struct wm_server* server, double at_x, double at_y, 
+        struct wlr_surface** result, double* result_sx, double* result_sy, double* result_scale_x, double* result_scale_y){
+    struct wm_content** candidates;
+    int n_candidates = wm_spatial_candidates_at(server->wm_spatial, at_x, at_y, &candidates);
 
-        double sx;
-        double sy;
-        struct wlr_surface* surface = wm_view_surface_at(view, view_at_x, view_at_y, &sx, &sy);
+    if(n_candidates < 0){
+        struct wm_content* content;
+        wl_list_for_each(content, &server->wm_contents, link){
+            if(!wm_content_is_view(content)) continue;
 
-        if(surface){
-            *result = surface;
-            if(result_sx) *result_sx = sx;
-            if(result_sy) *result_sy = sy;
-            if(result_scale_x) *result_scale_x = scale_x;
-            if(result_scale_y) *result_scale_y = scale_y;
-            return;
+            *result = view_surface_at(wm_cast(wm_view, content), at_x, at_y, result_sx, result_sy, result_scale_x, result_scale_y);
+            if(*result) return;
         }
     }
 
-    *result = NULL;
-}
-
-struct _view_for_surface_data {
-    struct wlr_surface* surface;
-    bool result;
-};
-
-static void _view_for_surface(struct wlr_surface* surface, int sx, int sy, bool constrained, void* _data){
-    struct _view_for_surface_data* data = _data;
-    if(surface == data->surface){
-        data->result = true;
-        return;
+    for(int i=0; i<n_candidates; i++){
+        *result = view_surface_at(wm_cast(wm_view, candidates[i]), at_x, at_y, result_sx, result_sy, result_scale_x, result_scale_y);
+        if(*result) return;
     }
+
+    *result = NULL;
 }
 
 struct wm_view* wm_server_view_for_surface(struct wm_server* server, struct wlr_surface* surface){
-    struct wm_content* content;
-    wl_list_for_each(content, &server->wm_contents, link){
-        if(!wm_content_is_view(content)) continue;
-        struct wm_view* view = wm_cast(wm_view, content);
-
-        struct _view_for_surface_data data = { 0 };
-        data.surface = surface;
-        wm_view_for_each_surface(view, _view_for_surface, &data);
-        if(data.result){
-            return view;
-        }
-    }
-
-    return NULL;
+    return wm_view_for_surface(server, surface);
 }
 
 struct wm_widget* wm_server_create_widget(struct wm_server* server){
@@ -519,38 +544,38 @@ void wm_server_close_virtual_output(struct wm_server* server, const char* name){
 }
 
 void wm_server_update_contents(struct wm_server* server){
-    /* Empty or only one element */
-    if(server->wm_contents.next == server->wm_contents.prev) return;
+    /* wm_contents is kept ordered by wm_content_set_z_index - nothing moved */
+    if(server->wm_contents_generation == server->wm_contents_sorted_generation) return;
 
-    int swapped = 1;
-    do {
-        swapped = 0;
-
-        struct wl_list* cur1 = server->wm_contents.next;
-        struct wl_list* cur2 = cur1->next;
-        for(;cur1 != server->wm_contents.prev; 
-                cur1 = cur1->next, cur2 = cur2->next){
-
-            struct wm_content* content1 = wl_container_of(cur1, content1, link);
-            struct wm_content* content2 = wl_container_of(cur2, content2, link);
-
-            if(wm_content_get_z_index(content1)<wm_content_get_z_index(content2)){
-                cur1->prev->next = cur2;
-                cur2->next->prev = cur1;
-
-                cur1->next = cur2->next;
-                cur2->prev = cur1->prev;
+    /*
+     * Insertion sort as a safeguard; linear on the (already ordered) list.
+     * Stable, i.e. contents with equal z-index keep their order.
+     */
+    struct wl_list* cur = server->wm_contents.next->next;
+    while(cur != &server->wm_contents){
+        struct wl_list* next = cur->next;
+        struct wm_content* content = wl_container_of(cur, content, link);
+        struct wl_list* pos = cur->prev;
+        while(pos != &server->wm_contents){
+            struct wm_content* prev = wl_container_of(pos, prev, link);
+            if(wm_content_get_z_index(prev) >= wm_content_get_z_index(content)) break;
+            pos = pos->prev;
+        }
+        if(pos != cur->prev){
+            wl_list_remove(cur);
+            wl_list_insert(pos, cur);
+        }
 
-                cur2->next = cur1;
-                cur1->prev = cur2;
+        cur = next;
+    }
 
-                cur1 = cur1->prev;
-                cur2 = cur1;
-                swapped = 1;
-            }
-        }
+    int z_order = 0;
+    struct wm_content* content;
+    wl_list_for_each(content, &server->wm_contents, link){
+        content->z_order = z_order++;
+    }
 
-    } while(swapped);
+    server->wm_contents_sorted_generation = server->wm_contents_generation;
 }
 
 
@@ -0,0 +1,208 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <wlr/util/log.h>
+
+#include "wm/wm_shader_cache.h"
+
+#define WM_SHADER_CACHE_MAGIC 0x4d48535f4d575950ULL /* "PYWM_SHM" */
+#define WM_SHADER_CACHE_VERSION 1
+
+struct wm_shader_cache_header {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t format;
+    uint64_t key;
+    uint32_t length;
+};
+
+/* FNV-1a */
+static uint64_t hash_str(uint64_t hash, const char* str){
+    if(!str) str = "";
+    for(const unsigned char* c = (const unsigned char*)str; ; c++){
+        hash ^= *c;
+        hash *= 0x100000001b3ULL;
+        if(!*c) break;
+    }
+    return hash;
+}
+
+static uint64_t cache_key(struct wm_shader_cache* cache, const GLchar* vert_src, const GLchar* frag_src){
+    uint64_t key = cache->driver_hash;
+    key = hash_str(key, vert_src);
+    key = hash_str(key, frag_src);
+    return key;
+}
+
+static void cache_path(struct wm_shader_cache* cache, uint64_t key, char* path, size_t size){
+    snprintf(path, size, "%s/%016" PRIx64 ".bin", cache->dir, key);
+}
+
+static bool mkdir_p(char* path){
+    for(char* c = path + 1; *c; c++){
+        if(*c != '/') continue;
+        *c = 0;
+        if(mkdir(path, 0700) < 0 && errno != EEXIST){
+            *c = '/';
+            return false;
+        }
+        *c = '/';
+    }
+    return mkdir(path, 0700) == 0 || errno == EEXIST;
+}
+
+void wm_shader_cache_init(struct wm_shader_cache* cache){
+    cache->enabled = false;
+    cache->n_hits = 0;
+    cache->n_misses = 0;
+
+    const char* env = getenv("PYWM_SHADER_CACHE");
+    if(env && !strcmp(env, "0")){
+        wlr_log(WLR_INFO, "Shader cache: Disabled");
+        return;
+    }
+
+    GLint n_formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &n_formats);
+    if(n_formats <= 0){
+        wlr_log(WLR_INFO, "Shader cache: No program binary formats supported");
+        return;
+    }
+
+    const char* xdg_cache = getenv("XDG_CACHE_HOME");
+    const char* home = getenv("HOME");
+    if(xdg_cache && xdg_cache[0]){
+        snprintf(cache->dir, sizeof(cache->dir), "%s/pywm/shaders", xdg_cache);
+    }else if(home && home[0]){
+        snprintf(cache->dir, sizeof(cache->dir), "%s/.cache/pywm/shaders", home);
+    }else{
+        wlr_log(WLR_INFO, "Shader cache: No cache directory");
+        return;
+    }
+
+    if(!mkdir_p(cache->dir)){
+        wlr_log_errno(WLR_ERROR, "Shader cache: Could not create %s", cache->dir);
+        return;
+    }
+
+    cache->driver_hash = 0xcbf29ce484222325ULL;
+    cache->driver_hash = hash_str(cache->driver_hash, (const char*)glGetString(GL_VENDOR));
+    cache->driver_hash = hash_str(cache->driver_hash, (const char*)glGetString(GL_RENDERER));
+    cache->driver_hash = hash_str(cache->driver_hash, (const char*)glGetString(GL_VERSION));
+    cache->driver_hash = hash_str(cache->driver_hash, (const char*)glGetString(GL_SHADING_LANGUAGE_VERSION));
+
+    wlr_log(WLR_DEBUG, "Shader cache: Using %s", cache->dir);
+    cache->enabled = true;
+}
+
+GLuint wm_shader_cache_load(struct wm_shader_cache* cache, const GLchar* vert_src, const GLchar* frag_src){
+    if(!cache->enabled) return 0;
+
+    uint64_t key = cache_key(cache, vert_src, frag_src);
+    char path[PATH_MAX + 32];
+    cache_path(cache, key, path, sizeof(path));
+
+    FILE* f = fopen(path, "rb");
+    if(!f){
+        cache->n_misses++;
+        return 0;
+    }
+
+    GLuint prog = 0;
+    void* binary = NULL;
+
+    struct wm_shader_cache_header header;
+    if(fread(&header, sizeof(header), 1, f) != 1 ||
+            header.magic != WM_SHADER_CACHE_MAGIC ||
+            header.version != WM_SHADER_CACHE_VERSION ||
+            header.key != key ||
+            header.length == 0){
+        goto invalid;
+    }
+
+    binary = malloc(header.length);
+    if(!binary || fread(binary, header.length, 1, f) != 1){
+        goto invalid;
+    }
+
+    prog = glCreateProgram();
+    glProgramBinary(prog, header.format, binary, header.length);
+
+    GLint ok;
+    glGetProgramiv(prog, GL_LINK_STATUS, &ok);
+    if(ok == GL_FALSE){
+        glDeleteProgram(prog);
+        prog = 0;
+        goto invalid;
+    }
+
+    free(binary);
+    fclose(f);
+    cache->n_hits++;
+    return prog;
+
+invalid:
+    /* Stale or corrupt - e.g. driver update without version change */
+    wlr_log(WLR_DEBUG, "Shader cache: Removing invalid entry %s", path);
+    free(binary);
+    fclose(f);
+    unlink(path);
+    cache->n_misses++;
+    return 0;
+}
+
+void wm_shader_cache_store(struct wm_shader_cache* cache, GLuint prog, const GLchar* vert_src, const GLchar* frag_src){
+    if(!cache->enabled) return;
+
+    GLint length = 0;
+    glGetProgramiv(prog, GL_PROGRAM_BINARY_LENGTH, &length);
+    if(length <= 0) return;
+
+    void* binary = malloc(length);
+    if(!binary) return;
+
+    GLenum format;
+    GLsizei written = 0;
+    glGetProgramBinary(prog, length, &written, &format, binary);
+    if(written <= 0){
+        free(binary);
+        return;
+    }
+
+    struct wm_shader_cache_header header = {
+        .magic = WM_SHADER_CACHE_MAGIC,
+        .version = WM_SHADER_CACHE_VERSION,
+        .format = format,
+        .key = cache_key(cache, vert_src, frag_src),
+        .length = written,
+    };
+
+    /* Write to a temporary file first, so concurrent instances never read partial entries */
+    char path[PATH_MAX + 32];
+    char tmp_path[PATH_MAX + 64];
+    cache_path(cache, header.key, path, sizeof(path));
+    snprintf(tmp_path, sizeof(tmp_path), "%s.%d.tmp", path, (int)getpid());
+
+    FILE* f = fopen(tmp_path, "wb");
+    if(!f){
+        wlr_log_errno(WLR_DEBUG, "Shader cache: Could not write %s", tmp_path);
+        free(binary);
+        return;
+    }
+
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+        fwrite(binary, written, 1, f) == 1;
+    ok = fclose(f) == 0 && ok;
+    free(binary);
+
+    if(!ok || rename(tmp_path, path) < 0){
+        wlr_log_errno(WLR_DEBUG, "Shader cache: Could not write %s", path);
+        unlink(tmp_path);
+    }
+}
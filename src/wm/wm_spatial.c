@@ -0,0 +1,230 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <wayland-server.h>
+#include <wlr/types/wlr_output_layout.h>
+#include <wlr/util/box.h>
+#include <wlr/util/log.h>
+
+#include "wm/wm_spatial.h"
+#include "wm/wm_server.h"
+#include "wm/wm_layout.h"
+#include "wm/wm_content.h"
+#include "wm/wm_view.h"
+
+static void cell_insert(struct wm_spatial_cell* cell, struct wm_content* content){
+    if(cell->n_contents == cell->size_contents){
+        cell->size_contents = cell->size_contents ? 2 * cell->size_contents : 8;
+        cell->contents = realloc(cell->contents, cell->size_contents * sizeof(struct wm_content*));
+        assert(cell->contents);
+    }
+    cell->contents[cell->n_contents++] = content;
+    cell->dirty = true;
+}
+
+static void cell_remove(struct wm_spatial_cell* cell, struct wm_content* content){
+    for(int i=0; i<cell->n_contents; i++){
+        if(cell->contents[i] == content){
+            cell->contents[i] = cell->contents[--cell->n_contents];
+            cell->dirty = true;
+            return;
+        }
+    }
+    wlr_log(WLR_ERROR, "Content not registered in spatial cell");
+}
+
+static void cell_ensure_order(struct wm_spatial_cell* cell, unsigned long generation){
+    if(!cell->dirty && cell->generation == generation) return;
+
+    /* Insertion sort - cells are small and mostly ordered */
+    for(int i=1; i<cell->n_contents; i++){
+        struct wm_content* content = cell->contents[i];
+        int j = i - 1;
+        for(; j>=0 && cell->contents[j]->z_order > content->z_order; j--){
+            cell->contents[j + 1] = cell->contents[j];
+        }
+        cell->contents[j + 1] = content;
+    }
+
+    cell->dirty = false;
+    cell->generation = generation;
+}
+
+static int cell_x(struct wm_spatial* spatial, double x){
+    int res = floor((x - spatial->x) / WM_SPATIAL_CELL_SIZE);
+    return res < 0 ? 0 : res >= spatial->cols ? spatial->cols - 1 : res;
+}
+
+static int cell_y(struct wm_spatial* spatial, double y){
+    int res = floor((y - spatial->y) / WM_SPATIAL_CELL_SIZE);
+    return res < 0 ? 0 : res >= spatial->rows ? spatial->rows - 1 : res;
+}
+
+static bool is_registered(struct wm_content* content){
+    return content->spatial_unbounded || content->spatial_x0 <= content->spatial_x1;
+}
+
+static void unregister(struct wm_content* content){
+    content->spatial_unbounded = false;
+    content->spatial_x0 = 0;
+    content->spatial_y0 = 0;
+    content->spatial_x1 = -1;
+    content->spatial_y1 = -1;
+}
+
+void wm_spatial_init(struct wm_spatial* spatial, struct wm_server* server){
+    spatial->wm_server = server;
+
+    spatial->cells = NULL;
+    spatial->unbounded = (struct wm_spatial_cell){ 0 };
+    spatial->n_views = 0;
+    spatial->candidates = NULL;
+    spatial->size_candidates = 0;
+
+    wm_spatial_reconfigure(spatial);
+}
+
+static void free_cells(struct wm_spatial* spatial){
+    if(spatial->cells){
+        for(int i=0; i<spatial->cols * spatial->rows; i++){
+            free(spatial->cells[i].contents);
+        }
+        free(spatial->cells);
+        spatial->cells = NULL;
+    }
+}
+
+void wm_spatial_destroy(struct wm_spatial* spatial){
+    free_cells(spatial);
+    free(spatial->unbounded.contents);
+    free(spatial->candidates);
+}
+
+void wm_spatial_reconfigure(struct wm_spatial* spatial){
+    free_cells(spatial);
+    spatial->unbounded.n_contents = 0;
+    spatial->n_views = 0;
+
+    struct wlr_box box = { 0 };
+    if(spatial->wm_server->wm_layout){
+        wlr_output_layout_get_box(spatial->wm_server->wm_layout->wlr_output_layout, NULL, &box);
+    }
+
+    /* Always keep at least one cell; positions outside of the grid are clamped to it */
+    spatial->x = box.x;
+    spatial->y = box.y;
+    spatial->cols = box.width > 0 ? (box.width + WM_SPATIAL_CELL_SIZE - 1) / WM_SPATIAL_CELL_SIZE : 1;
+    spatial->rows = box.height > 0 ? (box.height + WM_SPATIAL_CELL_SIZE - 1) / WM_SPATIAL_CELL_SIZE : 1;
+    spatial->cells = calloc(spatial->cols * spatial->rows, sizeof(struct wm_spatial_cell));
+    assert(spatial->cells);
+
+    struct wm_content* content;
+    wl_list_for_each(content, &spatial->wm_server->wm_contents, link){
+        unregister(content);
+        wm_spatial_update(spatial, content);
+    }
+}
+
+void wm_spatial_update(struct wm_spatial* spatial, struct wm_content* content){
+    if(!wm_content_is_view(content)) return;
+
+    bool unbounded = !wm_content_has_workspace(content);
+    int x0 = 0, y0 = 0, x1 = -1, y1 = -1;
+    if(!unbounded){
+        double x, y, w, h;
+        wm_content_get_workspace(content, &x, &y, &w, &h);
+        x0 = cell_x(spatial, x);
+        y0 = cell_y(spatial, y);
+        x1 = cell_x(spatial, x + w);
+        y1 = cell_y(spatial, y + h);
+    }
+
+    if(is_registered(content) &&
+            unbounded == content->spatial_unbounded &&
+            x0 == content->spatial_x0 && y0 == content->spatial_y0 &&
+            x1 == content->spatial_x1 && y1 == content->spatial_y1) return;
+
+    wm_spatial_remove(spatial, content);
+
+    content->spatial_unbounded = unbounded;
+    content->spatial_x0 = x0;
+    content->spatial_y0 = y0;
+    content->spatial_x1 = x1;
+    content->spatial_y1 = y1;
+    spatial->n_views++;
+
+    if(unbounded){
+        cell_insert(&spatial->unbounded, content);
+        return;
+    }
+
+    for(int cy=y0; cy<=y1; cy++){
+        for(int cx=x0; cx<=x1; cx++){
+            cell_insert(&spatial->cells[cy * spatial->cols + cx], content);
+        }
+    }
+}
+
+void wm_spatial_remove(struct wm_spatial* spatial, struct wm_content* content){
+    if(!is_registered(content)) return;
+
+    if(content->spatial_unbounded){
+        cell_remove(&spatial->unbounded, content);
+    }else{
+        for(int cy=content->spatial_y0; cy<=content->spatial_y1; cy++){
+            for(int cx=content->spatial_x0; cx<=content->spatial_x1; cx++){
+                cell_remove(&spatial->cells[cy * spatial->cols + cx], content);
+            }
+        }
+    }
+
+    unregister(content);
+    spatial->n_views--;
+}
+
+int wm_spatial_candidates_at(struct wm_spatial* spatial, double x, double y, struct wm_content*** result){
+    /* Ensure wm_content::z_order */
+    wm_server_update_contents(spatial->wm_server);
+    unsigned long generation = spatial->wm_server->wm_contents_generation;
+
+    struct wm_spatial_cell* cell = &spatial->cells[cell_y(spatial, y) * spatial->cols + cell_x(spatial, x)];
+
+    /* The grid does not narrow down anything here */
+    int n = cell->n_contents + spatial->unbounded.n_contents;
+    if(n > 0 && 8 * n >= WM_SPATIAL_LINEAR_EIGHTHS * spatial->n_views){
+        *result = NULL;
+        return -1;
+    }
+
+    /* Nothing to merge */
+    if(!spatial->unbounded.n_contents){
+        cell_ensure_order(cell, generation);
+        *result = cell->contents;
+        return cell->n_contents;
+    }
+
+    cell_ensure_order(cell, generation);
+    cell_ensure_order(&spatial->unbounded, generation);
+
+    if(n > spatial->size_candidates){
+        spatial->size_candidates = 2 * n;
+        spatial->candidates = realloc(spatial->candidates, spatial->size_candidates * sizeof(struct wm_content*));
+        assert(spatial->candidates);
+    }
+
+    /* Merge both ordered lists */
+    int i = 0, j = 0, k = 0;
+    while(i < cell->n_contents || j < spatial->unbounded.n_contents){
+        if(j >= spatial->unbounded.n_contents ||
+                (i < cell->n_contents && cell->contents[i]->z_order < spatial->unbounded.contents[j]->z_order)){
+            spatial->candidates[k++] = cell->contents[i++];
+        }else{
+            spatial->candidates[k++] = spatial->unbounded.contents[j++];
+        }
+    }
+
+    *result = spatial->candidates;
+    return k;
+}
@@ -4,6 +4,7 @@
 #include <stdlib.h>
 #include <wayland-server.h>
 #include <wlr/types/wlr_xdg_shell.h>
+#include <wlr/types/wlr_subcompositor.h>
 #include <wlr/util/log.h>
 #include <wlr/util/region.h>
 
@@ -13,6 +14,7 @@
 #include "wm/wm_renderer.h"
 #include "wm/wm_server.h"
 #include "wm/wm_layout.h"
+#include "wm/wm_spatial.h"
 #include "wm/wm.h"
 
 #include "wm/wm_util.h"
@@ -33,15 +35,77 @@ void wm_view_base_init(struct wm_view* view, struct wm_server* server){
     view->accepts_input = true;
 
     view->shows_csd = false;
+
+    view->dirty = WM_VIEW_DIRTY_ALL;
+
+    wl_list_init(&view->surfaces);
+
+    wm_spatial_update(server->wm_spatial, &view->super);
 }
 
 static void wm_view_base_destroy(struct wm_content* super){
     struct wm_view* view = wm_cast(wm_view, super);
 
     (view->vtable->destroy)(view);
+
+    struct wm_view_surface* view_surface;
+    struct wm_view_surface* tmp;
+    wl_list_for_each_safe(view_surface, tmp, &view->surfaces, link){
+        wm_view_surface_finish(view_surface);
+    }
+
+    wm_spatial_remove(super->wm_server->wm_spatial, super);
     wm_content_base_destroy(super);
 }
 
+static void view_surface_addon_destroy(struct wlr_addon* addon){
+    struct wm_view_surface* view_surface = wl_container_of(addon, view_surface, addon);
+    wm_view_surface_finish(view_surface);
+}
+
+static const struct wlr_addon_interface view_surface_addon_impl = {
+    .name = "wm_view_surface",
+    .destroy = view_surface_addon_destroy,
+};
+
+void wm_view_surface_init(struct wm_view_surface* view_surface, struct wm_view* view, struct wlr_surface* surface){
+    view_surface->view = NULL;
+    if(!view || !surface) return;
+
+    if(wlr_addon_find(&surface->addons, view->super.wm_server, &view_surface_addon_impl)){
+        wlr_log(WLR_DEBUG, "Surface is already associated with a view");
+        return;
+    }
+
+    view_surface->view = view;
+    wlr_addon_init(&view_surface->addon, &surface->addons, view->super.wm_server, &view_surface_addon_impl);
+    wl_list_insert(&view->surfaces, &view_surface->link);
+}
+
+void wm_view_surface_finish(struct wm_view_surface* view_surface){
+    if(!view_surface->view) return;
+
+    wlr_addon_finish(&view_surface->addon);
+    wl_list_remove(&view_surface->link);
+    view_surface->view = NULL;
+}
+
+struct wm_view* wm_view_for_surface(struct wm_server* server, struct wlr_surface* surface){
+    while(surface){
+        struct wlr_addon* addon = wlr_addon_find(&surface->addons, server, &view_surface_addon_impl);
+        if(addon){
+            struct wm_view_surface* view_surface = wl_container_of(addon, view_surface, addon);
+            return view_surface->view;
+        }
+
+        /* Not tracked (e.g. subsurfaces of XWayland surfaces) - resolve via parent */
+        struct wlr_subsurface* subsurface = wlr_subsurface_try_from_wlr_surface(surface);
+        surface = subsurface ? subsurface->parent : NULL;
+    }
+
+    return NULL;
+}
+
 bool wm_content_is_view(struct wm_content* content){
     return content->vtable == &wm_view_vtable;
 }
@@ -52,6 +116,7 @@ bool wm_view_shows_csd(struct wm_view* view){
 
 void wm_view_set_inhibiting_idle(struct wm_view* view, bool inhibiting_idle){
     view->inhibiting_idle = inhibiting_idle;
+    view->dirty |= WM_VIEW_DIRTY_STATE;
 }
 bool wm_view_is_inhibiting_idle(struct wm_view* view){
     return view->inhibiting_idle;
@@ -113,6 +113,7 @@ static void handle_map(struct wl_listener* listener, void* data){
     struct wm_view_layer* view = wl_container_of(listener, view, map);
 
     view->super.mapped = true;
+    wm_view_set_dirty(&view->super, WM_VIEW_DIRTY_MAPPED);
 
     wm_layout_damage_from(
         view->super.super.wm_server->wm_layout,
@@ -123,6 +124,7 @@ static void handle_map(struct wl_listener* listener, void* data){
 static void handle_unmap(struct wl_listener* listener, void* data){
     struct wm_view_layer* view = wl_container_of(listener, view, unmap);
     view->super.mapped = false;
+    wm_view_set_dirty(&view->super, WM_VIEW_DIRTY_MAPPED);
     wm_layout_damage_whole(view->super.super.wm_server->wm_layout);
 }
 
@@ -159,9 +161,13 @@ static void handle_surface_commit(struct wl_listener* listener, void* data){
     int width = view->wlr_layer_surface->surface->current.width;
     int height = view->wlr_layer_surface->surface->current.height;
 
+    /* Anchor, margins, ... are double-buffered state */
+    wm_view_set_dirty(&view->super, WM_VIEW_DIRTY_SIZE_CONSTRAINTS);
+
     if(width != view->width || height != view->height){
         view->width = width;
         view->height = height;
+        wm_view_set_dirty(&view->super, WM_VIEW_DIRTY_SIZE);
         wm_callback_update_view(&view->super);
     }else{
         view->width = width;
@@ -187,6 +193,7 @@ static void handle_surface_commit(struct wl_listener* listener, void* data){
 void wm_layer_subsurface_init(struct wm_layer_subsurface* subsurface, struct wm_view_layer* root, struct wlr_subsurface* wlr_subsurface){
     subsurface->root = root;
     subsurface->wlr_subsurface = wlr_subsurface;
+    wm_view_surface_init(&subsurface->view_surface, root ? &root->super : NULL, wlr_subsurface->surface);
 
     wl_list_init(&subsurface->subsurfaces);
 
@@ -218,6 +225,7 @@ void wm_layer_subsurface_init(struct wm_layer_subsurface* subsurface, struct wm_
 }
 
 void wm_layer_subsurface_destroy(struct wm_layer_subsurface* subsurface){
+    wm_view_surface_finish(&subsurface->view_surface);
     wl_list_remove(&subsurface->link);
     wl_list_remove(&subsurface->subsurfaces);
     wl_list_remove(&subsurface->map.link);
@@ -234,6 +242,7 @@ void wm_popup_layer_init(struct wm_popup_layer* popup, struct wm_view_layer* roo
 
     popup->wlr_xdg_popup = wlr_xdg_popup;
     popup->root = root;
+    wm_view_surface_init(&popup->view_surface, root ? &root->super : NULL, wlr_xdg_popup->base->surface);
 
     wl_list_init(&popup->subsurfaces);
     wl_list_init(&popup->popups);
@@ -281,6 +290,7 @@ void wm_popup_layer_init(struct wm_popup_layer* popup, struct wm_view_layer* roo
 }
 
 void wm_popup_layer_destroy(struct wm_popup_layer* popup){
+    wm_view_surface_finish(&popup->view_surface);
     wl_list_remove(&popup->link);
     wl_list_remove(&popup->popups);
     wl_list_remove(&popup->subsurfaces);
@@ -301,6 +311,7 @@ void wm_view_layer_init(struct wm_view_layer* view, struct wm_server* server, st
     view->super.vtable = &wm_view_layer_vtable;
 
     view->wlr_layer_surface = surface;
+    wm_view_surface_init(&view->view_surface, &view->super, surface->surface);
 
     wl_list_init(&view->popups);
     wl_list_init(&view->subsurfaces);
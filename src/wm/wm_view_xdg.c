@@ -142,9 +142,7 @@ static void handle_map(struct wl_listener* listener, void* data){
     struct wm_view_xdg* view = wl_container_of(listener, view, map);
 
     view->super.mapped = true;
-
-    /* Add view to the list of views */
-    wl_list_insert(&view->super.super.wm_server->wm_contents, &view->super.super.link);
+    wm_view_set_dirty(&view->super, WM_VIEW_DIRTY_MAPPED);
 
     wm_layout_damage_from(
         view->super.super.wm_server->wm_layout,
@@ -155,9 +153,7 @@ static void handle_map(struct wl_listener* listener, void* data){
 static void handle_unmap(struct wl_listener* listener, void* data){
     struct wm_view_xdg* view = wl_container_of(listener, view, unmap);
     view->super.mapped = false;
-
-    /* Remove view from the list of views */
-    wl_list_remove(&view->super.super.link);
+    wm_view_set_dirty(&view->super, WM_VIEW_DIRTY_MAPPED);
 
     wm_layout_damage_whole(view->super.super.wm_server->wm_layout);
 }
@@ -226,6 +222,7 @@ static bool possibly_update_size(struct wm_view_xdg* view){
     if(width != view->width || height != view->height){
         view->width = width;
         view->height = height;
+        wm_view_set_dirty(&view->super, WM_VIEW_DIRTY_SIZE);
         return true;
     }
 
@@ -279,6 +276,9 @@ static void handle_surface_commit(struct wl_listener* listener, void* data){
 
     update |= possibly_update_size(view);
 
+    /* Geometry and min / max size are double-buffered state */
+    wm_view_set_dirty(&view->super, WM_VIEW_DIRTY_OFFSET | WM_VIEW_DIRTY_SIZE_CONSTRAINTS);
+
     if(update){
         wm_callback_update_view(&view->super);
     }
@@ -324,6 +324,21 @@ static void handle_maximize(struct wl_listener* listener, void* data){
     wm_callback_view_event(&view->super, "request_maximize");
 }
 
+static void handle_set_title(struct wl_listener* listener, void* data){
+    struct wm_view_xdg* view = wl_container_of(listener, view, set_title);
+    wm_view_set_dirty(&view->super, WM_VIEW_DIRTY_INFO);
+}
+
+static void handle_set_app_id(struct wl_listener* listener, void* data){
+    struct wm_view_xdg* view = wl_container_of(listener, view, set_app_id);
+    wm_view_set_dirty(&view->super, WM_VIEW_DIRTY_INFO);
+}
+
+static void handle_set_parent(struct wl_listener* listener, void* data){
+    struct wm_view_xdg* view = wl_container_of(listener, view, set_parent);
+    wm_view_set_dirty(&view->super, WM_VIEW_DIRTY_INFO);
+}
+
 static void handle_show_window_menu(struct wl_listener* listener, void* data){
     struct wm_view_xdg* view = wl_container_of(listener, view, request_show_window_menu);
 
@@ -336,6 +351,7 @@ static void handle_show_window_menu(struct wl_listener* listener, void* data){
 void wm_xdg_subsurface_init(struct wm_xdg_subsurface* subsurface, struct wm_view_xdg* toplevel, struct wlr_subsurface* wlr_subsurface){
     subsurface->toplevel = toplevel;
     subsurface->wlr_subsurface = wlr_subsurface;
+    wm_view_surface_init(&subsurface->view_surface, toplevel ? &toplevel->super : NULL, wlr_subsurface->surface);
 
     wl_list_init(&subsurface->subsurfaces);
 
@@ -368,6 +384,7 @@ void wm_xdg_subsurface_init(struct wm_xdg_subsurface* subsurface, struct wm_view
 }
 
 void wm_xdg_subsurface_destroy(struct wm_xdg_subsurface* subsurface){
+    wm_view_surface_finish(&subsurface->view_surface);
     wl_list_remove(&subsurface->link);
     wl_list_remove(&subsurface->subsurfaces);
     wl_list_remove(&subsurface->map.link);
@@ -385,6 +402,7 @@ void wm_popup_xdg_init(struct wm_popup_xdg* popup, struct wm_view_xdg* toplevel,
 
     popup->wlr_xdg_popup = wlr_xdg_popup;
     popup->toplevel = toplevel;
+    wm_view_surface_init(&popup->view_surface, toplevel ? &toplevel->super : NULL, wlr_xdg_popup->base->surface);
 
     wl_list_init(&popup->subsurfaces);
     wl_list_init(&popup->popups);
@@ -448,6 +466,7 @@ void wm_popup_xdg_init(struct wm_popup_xdg* popup, struct wm_view_xdg* toplevel,
 }
 
 void wm_popup_xdg_destroy(struct wm_popup_xdg* popup){
+    wm_view_surface_finish(&popup->view_surface);
     wl_list_remove(&popup->link);
     wl_list_remove(&popup->popups);
     wl_list_remove(&popup->subsurfaces);
@@ -471,6 +490,7 @@ void wm_view_xdg_init(struct wm_view_xdg* view, struct wm_server* server, struct
     view->floating_set = -1;
 
     view->wlr_xdg_surface = surface;
+    wm_view_surface_init(&view->view_surface, &view->super, surface->surface);
     view->wlr_deco = NULL;
     view->wlr_server_deco = NULL;
 
@@ -520,6 +540,15 @@ void wm_view_xdg_init(struct wm_view_xdg* view, struct wm_server* server, struct
     view->request_show_window_menu.notify = &handle_show_window_menu;
     wl_signal_add(&surface->toplevel->events.request_show_window_menu, &view->request_show_window_menu);
 
+    view->set_title.notify = &handle_set_title;
+    wl_signal_add(&surface->toplevel->events.set_title, &view->set_title);
+
+    view->set_app_id.notify = &handle_set_app_id;
+    wl_signal_add(&surface->toplevel->events.set_app_id, &view->set_app_id);
+
+    view->set_parent.notify = &handle_set_parent;
+    wl_signal_add(&surface->toplevel->events.set_parent, &view->set_parent);
+
     /* Create scene node for this view */
     struct wlr_scene_tree* scene_tree = wlr_scene_xdg_surface_create(&server->wlr_scene->tree, surface);
     view->scene_node = &scene_tree->node;
@@ -583,6 +612,10 @@ static void wm_view_xdg_destroy(struct wm_view* super){
     wl_list_remove(&view->request_maximize.link);
     wl_list_remove(&view->request_minimize.link);
     wl_list_remove(&view->request_show_window_menu.link);
+
+    wl_list_remove(&view->set_title.link);
+    wl_list_remove(&view->set_app_id.link);
+    wl_list_remove(&view->set_parent.link);
 }
 
 static void wm_view_xdg_get_credentials(struct wm_view* super, pid_t* pid, uid_t* uid, gid_t* gid){
@@ -828,6 +861,7 @@ static void server_deco_handle_mode(struct wl_listener* listener, void* data){
             (view->wlr_server_deco->mode == WLR_SERVER_DECORATION_MANAGER_MODE_CLIENT ? "CSD" : ""));
 
     view->super.shows_csd = view->wlr_server_deco->mode == WLR_SERVER_DECORATION_MANAGER_MODE_CLIENT;
+    wm_view_set_dirty(&view->super, WM_VIEW_DIRTY_CSD);
 }
 
 static void server_deco_handle_destroy(struct wl_listener* listener, void* data){
@@ -849,6 +883,7 @@ void wm_view_xdg_register_server_decoration(struct wm_view_xdg* view, struct wlr
     wl_signal_add(&wlr_deco->events.destroy, &view->server_deco_destroy);
 
     view->super.shows_csd = wlr_deco->mode == WLR_SERVER_DECORATION_MANAGER_MODE_CLIENT;
+    wm_view_set_dirty(&view->super, WM_VIEW_DIRTY_CSD);
 }
 
 static void deco_handle_request_mode(struct wl_listener* listener, void* data){
@@ -862,6 +897,7 @@ static void deco_handle_request_mode(struct wl_listener* listener, void* data){
             WLR_XDG_TOPLEVEL_DECORATION_V1_MODE_SERVER_SIDE);
 
     view->super.shows_csd = wm_view_xdg_encourage_csd(view);
+    wm_view_set_dirty(&view->super, WM_VIEW_DIRTY_CSD);
 }
 
 static void deco_handle_destroy(struct wl_listener* listener, void* data){
@@ -68,6 +68,7 @@ Found:
             /* Child view */
             view->super.floating = true;
             view->parent = parent;
+            wm_view_set_dirty(&view->super, WM_VIEW_DIRTY_INFO | WM_VIEW_DIRTY_STATE);
         }else{
             wlr_log(WLR_DEBUG, "XWayland: Detected popup disguised as new view... allocating xwayland_child");
 
@@ -87,6 +88,7 @@ Found:
 static void child_handle_map(struct wl_listener* listener, void* data){
     struct wm_view_xwayland_child* child = wl_container_of(listener, child, map);
     child->mapped = true;
+    wm_view_surface_init(&child->view_surface, &child->parent->super, child->wlr_xwayland_surface->surface);
 
     wm_layout_damage_from(
         child->parent->super.super.wm_server->wm_layout,
@@ -106,6 +108,7 @@ static void child_handle_request_configure(struct wl_listener* listener, void* d
 static void child_handle_unmap(struct wl_listener* listener, void* data){
     struct wm_view_xwayland_child* child = wl_container_of(listener, child, unmap);
     child->mapped = false;
+    wm_view_surface_finish(&child->view_surface);
 
     wm_layout_damage_whole(
         child->parent->super.super.wm_server->wm_layout);
@@ -136,6 +139,7 @@ static void handle_request_configure(struct wl_listener* listener, void* data){
 static void handle_set_pid(struct wl_listener* listener, void* data){
     struct wm_view_xwayland* view = wl_container_of(listener, view, set_pid);
 
+    wm_view_set_dirty(&view->super, WM_VIEW_DIRTY_INFO);
     try_to_find_parent(view);
 }
 
@@ -145,6 +149,16 @@ static void handle_set_parent(struct wl_listener* listener, void* data){
     try_to_find_parent(view);
 }
 
+static void handle_set_title(struct wl_listener* listener, void* data){
+    struct wm_view_xwayland* view = wl_container_of(listener, view, set_title);
+    wm_view_set_dirty(&view->super, WM_VIEW_DIRTY_INFO);
+}
+
+static void handle_set_class(struct wl_listener* listener, void* data){
+    struct wm_view_xwayland* view = wl_container_of(listener, view, set_class);
+    wm_view_set_dirty(&view->super, WM_VIEW_DIRTY_INFO);
+}
+
 static void handle_map(struct wl_listener* listener, void* data){
     struct wm_view_xwayland* view = wl_container_of(listener, view, map);
 
@@ -156,6 +170,8 @@ static void handle_map(struct wl_listener* listener, void* data){
 
     wm_callback_init_view(&view->super);
     view->super.mapped = true;
+    wm_view_set_dirty(&view->super, WM_VIEW_DIRTY_MAPPED | WM_VIEW_DIRTY_SIZE);
+    wm_view_surface_init(&view->view_surface, &view->super, view->wlr_xwayland_surface->surface);
 
     wm_layout_damage_from(
         view->super.super.wm_server->wm_layout,
@@ -168,6 +184,8 @@ static void handle_map(struct wl_listener* listener, void* data){
 static void handle_unmap(struct wl_listener* listener, void* data){
     struct wm_view_xwayland* view = wl_container_of(listener, view, unmap);
     view->super.mapped = false;
+    wm_view_set_dirty(&view->super, WM_VIEW_DIRTY_MAPPED | WM_VIEW_DIRTY_SIZE);
+    wm_view_surface_finish(&view->view_surface);
 
     wm_layout_damage_whole(view->super.super.wm_server->wm_layout);
 }
@@ -183,6 +201,8 @@ static void handle_destroy(struct wl_listener* listener, void* data){
 static void handle_surface_commit(struct wl_listener* listener, void* data){
     struct wm_view_xwayland* view = wl_container_of(listener, view, surface_commit);
 
+    wm_view_set_dirty(&view->super, WM_VIEW_DIRTY_SIZE | WM_VIEW_DIRTY_SIZE_CONSTRAINTS);
+
     wm_layout_damage_from(
             view->super.super.wm_server->wm_layout,
             &view->super.super, view->wlr_xwayland_surface->surface);
@@ -215,6 +235,7 @@ void wm_view_xwayland_child_init(struct wm_view_xwayland_child* child, struct wm
 }
 
 void wm_view_xwayland_child_destroy(struct wm_view_xwayland_child* child){
+    wm_view_surface_finish(&child->view_surface);
     wl_list_remove(&child->request_configure.link);
     wl_list_remove(&child->map.link);
     wl_list_remove(&child->unmap.link);
@@ -244,6 +265,12 @@ void wm_view_xwayland_init(struct wm_view_xwayland* view, struct wm_server* serv
     view->set_pid.notify = &handle_set_pid;
     wl_signal_add(&surface->events.set_pid, &view->set_pid);
 
+    view->set_title.notify = &handle_set_title;
+    wl_signal_add(&surface->events.set_title, &view->set_title);
+
+    view->set_class.notify = &handle_set_class;
+    wl_signal_add(&surface->events.set_class, &view->set_class);
+
     view->map.notify = &handle_map;
     wl_signal_add(&surface->events.map, &view->map);
 
@@ -264,6 +291,8 @@ static void wm_view_xwayland_destroy(struct wm_view* super){
     wl_list_remove(&view->request_configure.link);
     wl_list_remove(&view->set_pid.link);
     wl_list_remove(&view->set_parent.link);
+    wl_list_remove(&view->set_title.link);
+    wl_list_remove(&view->set_class.link);
     wl_list_remove(&view->map.link);
     wl_list_remove(&view->unmap.link);
     wl_list_remove(&view->destroy.link);
@@ -1,6 +1,8 @@
 #define _POSIX_C_SOURCE 200809L
 
+#include <math.h>
 #include <stdlib.h>
+#include <wlr/interfaces/wlr_buffer.h>
 
 #include "wm/wm_widget.h"
 #include "wm/wm_server.h"
@@ -19,6 +21,7 @@ void wm_widget_init(struct wm_widget* widget, struct wm_server* server){
     widget->wlr_texture = NULL;
 
     widget->primitive.name = NULL;
+    widget->primitive.shader = -1;
     widget->primitive.params_int = NULL;
     widget->primitive.params_float = NULL;
 }
@@ -34,17 +37,132 @@ static void wm_widget_destroy(struct wm_content* super){
     wm_content_base_destroy(super);
 }
 
-void wm_widget_set_pixels(struct wm_widget* widget, uint32_t format, uint32_t stride, uint32_t width, uint32_t height, const void* data){
-    if(widget->wlr_texture){
-	// TODO(rewine): https://gitlab.freedesktop.org/wlroots/wlroots/-/merge_requests/3585
-        wlr_texture_destroy(widget->wlr_texture);
+/*
+ * wlr_buffer wrapping pixel data owned by the caller - lives on the stack of wm_widget_set_pixels
+ */
+struct wm_widget_pixels_buffer {
+    struct wlr_buffer base;
+
+    uint32_t format;
+    size_t stride;
+    const void* data;
+};
+
+static void pixels_buffer_destroy(struct wlr_buffer* wlr_buffer){
+    /* Nothing owned */
+}
+
+static bool pixels_buffer_begin_data_ptr_access(struct wlr_buffer* wlr_buffer, uint32_t flags, void** data, uint32_t* format, size_t* stride){
+    struct wm_widget_pixels_buffer* buffer = wl_container_of(wlr_buffer, buffer, base);
+    if(flags & WLR_BUFFER_DATA_PTR_ACCESS_WRITE) return false;
+
+    *data = (void*)buffer->data;
+    *format = buffer->format;
+    *stride = buffer->stride;
+    return true;
+}
+
+static void pixels_buffer_end_data_ptr_access(struct wlr_buffer* wlr_buffer){
+}
+
+static const struct wlr_buffer_impl pixels_buffer_impl = {
+    .destroy = &pixels_buffer_destroy,
+    .begin_data_ptr_access = &pixels_buffer_begin_data_ptr_access,
+    .end_data_ptr_access = &pixels_buffer_end_data_ptr_access,
+};
+
+/* Returns true if only region (texture coordinates) of the existing texture has been updated */
+static bool upload_pixels(struct wm_widget* widget, uint32_t format, uint32_t stride, uint32_t width, uint32_t height, const void* data, pixman_region32_t* region){
+    struct wlr_renderer* wlr_renderer = widget->super.wm_server->wm_renderer->wlr_renderer;
+
+    struct wm_widget_pixels_buffer buffer = {
+        .format = format,
+        .stride = stride,
+        .data = data
+    };
+    wlr_buffer_init(&buffer.base, &pixels_buffer_impl, width, height);
+
+    /* Upload into the existing texture if possible */
+    bool updated = false;
+    if(widget->wlr_texture && widget->wlr_texture->width == width && widget->wlr_texture->height == height){
+        updated = wlr_texture_update_from_buffer(widget->wlr_texture, &buffer.base, region);
+    }
+
+    if(!updated){
+        if(widget->wlr_texture){
+            wlr_texture_destroy(widget->wlr_texture);
+        }
+        widget->wlr_texture = wlr_texture_from_buffer(wlr_renderer, &buffer.base);
+
+        /* Renderers which keep referencing the buffer (pixman) need their own copy */
+        if(widget->wlr_texture && buffer.base.n_locks > 0){
+            wlr_texture_destroy(widget->wlr_texture);
+            widget->wlr_texture = wlr_texture_from_pixels(wlr_renderer, format, stride, width, height, data);
+        }
     }
-    widget->wlr_texture = wlr_texture_from_pixels(widget->super.wm_server->wm_renderer->wlr_renderer,
-            format, stride, width, height, data);
+
+    wlr_buffer_drop(&buffer.base);
+    return updated;
+}
+
+/* Damage the part of the widget box showing region (texture coordinates) */
+static void damage_pixels(struct wm_widget* widget, pixman_region32_t* region){
+    double x, y, w, h;
+    wm_content_get_box(&widget->super, &x, &y, &w, &h);
+
+    pixman_box32_t* extents = pixman_region32_extents(region);
+    double scale_x = w / widget->wlr_texture->width;
+    double scale_y = h / widget->wlr_texture->height;
+
+    struct wm_layout* layout = widget->super.wm_server->wm_layout;
+    struct wm_output* output;
+    wl_list_for_each(output, &layout->wm_outputs, link){
+        if(!wm_content_is_on_output(&widget->super, output)) continue;
+
+        double scale = output->wlr_output->scale;
+        double x0 = (x - output->layout_x + extents->x1 * scale_x) * scale;
+        double y0 = (y - output->layout_y + extents->y1 * scale_y) * scale;
+        double x1 = (x - output->layout_x + extents->x2 * scale_x) * scale;
+        double y1 = (y - output->layout_y + extents->y2 * scale_y) * scale;
+
+        pixman_region32_t damage;
+        pixman_region32_init_rect(&damage, floor(x0), floor(y0), ceil(x1) - floor(x0), ceil(y1) - floor(y0));
+        wm_layout_damage_output(layout, output, &damage, &widget->super);
+        pixman_region32_fini(&damage);
+    }
+}
+
+void wm_widget_set_pixels(struct wm_widget* widget, uint32_t format, uint32_t stride, uint32_t width, uint32_t height, const void* data){
+    pixman_region32_t region;
+    pixman_region32_init_rect(&region, 0, 0, width, height);
+    upload_pixels(widget, format, stride, width, height, data, &region);
+    pixman_region32_fini(&region);
+
     wm_widget_set_primitive(widget, NULL, 0, NULL, 0, NULL);
     wm_layout_damage_from(widget->super.wm_server->wm_layout, &widget->super, NULL);
 }
 
+void wm_widget_set_pixels_region(struct wm_widget* widget, uint32_t format, uint32_t stride, uint32_t width, uint32_t height, const void* data,
+        int region_x, int region_y, int region_width, int region_height){
+    pixman_region32_t region;
+    pixman_region32_init_rect(&region, region_x, region_y, region_width, region_height);
+    pixman_region32_intersect_rect(&region, &region, 0, 0, width, height);
+
+    if(!pixman_region32_not_empty(&region)){
+        pixman_region32_fini(&region);
+        return;
+    }
+
+    if(upload_pixels(widget, format, stride, width, height, data, &region) && !widget->primitive.name){
+        damage_pixels(widget, &region);
+    }else{
+        wm_widget_set_primitive(widget, NULL, 0, NULL, 0, NULL);
+        wm_layout_damage_from(widget->super.wm_server->wm_layout, &widget->super, NULL);
+    }
+
+    pixman_region32_fini(&region);
+}
+
 void wm_widget_set_primitive(struct wm_widget* widget, char* name, int n_params_int, int* params_int, int n_params_float, float* params_float){
     if(widget->primitive.name) free(widget->primitive.name);
     if(widget->primitive.params_int) free(widget->primitive.params_int);
@@ -61,6 +179,16 @@ void wm_widget_set_primitive(struct wm_widget* widget, char* name, int n_params_
     widget->primitive.n_params_int = n_params_int;
     widget->primitive.n_params_float = n_params_float;
 
+    /* Resolve once instead of looking up name every frame */
+    widget->primitive.shader = -1;
+    if(name){
+        struct wm_renderer* renderer = widget->super.wm_server->wm_renderer;
+        int shader = wm_renderer_get_primitive_shader(renderer, name);
+        if(wm_renderer_check_primitive_params(renderer, shader, n_params_int, n_params_float)){
+            widget->primitive.shader = shader;
+        }
+    }
+
     if(name && widget->wlr_texture){
         wlr_texture_destroy(widget->wlr_texture);
         widget->wlr_texture = NULL;
@@ -103,10 +231,10 @@ static void wm_widget_render(struct wm_content* super, struct wm_output* output,
                 super->lock_enabled ? 0.0 : super->wm_server->lock_perc);
     }else if(widget->primitive.name){
 #ifdef WM_CUSTOM_RENDERER
-        wm_renderer_select_primitive_shader(output->wm_server->wm_renderer, widget->primitive.name);
-        if(!wm_renderer_check_primitive_params(output->wm_server->wm_renderer, widget->primitive.n_params_int, widget->primitive.n_params_float)){
+        if(widget->primitive.shader < 0){
             return;
         }
+        wm_renderer_select_primitive_shader(output->wm_server->wm_renderer, widget->primitive.shader);
         wm_renderer_render_primitive(output->wm_server->wm_renderer, output_damage, &box,
                 wm_content_get_opacity(super) * (1. - (super->lock_enabled ? 0.0 : super->wm_server->lock_perc)),
                 widget->primitive.params_int, widget->primitive.params_float);